@@ -0,0 +1,93 @@
+#include "csdcaptionassets.h"
+
+#include <algorithm>
+
+namespace CSD::Internal {
+
+#ifdef CSD_HAVE_CAPTION_ASSETS
+// Defined in the source generated by csd-rasterize at build time.
+extern const unsigned char captionAssetData[];
+extern const std::size_t captionAssetSize;
+#endif
+
+const CaptionAssetBundle &CaptionAssetBundle::instance() {
+#ifdef CSD_HAVE_CAPTION_ASSETS
+    static const auto bundle =
+        CaptionAssetBundle(captionAssetData, captionAssetSize);
+#else
+    static const auto bundle = CaptionAssetBundle(nullptr, 0);
+#endif
+    return bundle;
+}
+
+CaptionAssetBundle::CaptionAssetBundle(const uchar *data, std::size_t size) {
+    if (data == nullptr || size < sizeof(CaptionAssetHeader)) {
+        return;
+    }
+    const auto *header = reinterpret_cast<const CaptionAssetHeader *>(data);
+    if (header->magic != kCaptionAssetMagic ||
+        header->version != kCaptionAssetVersion) {
+        qWarning("CaptionAssetBundle: bundle has an unexpected format");
+        return;
+    }
+    const auto tableSize = size - sizeof(CaptionAssetHeader);
+    if (header->entryCount > tableSize / sizeof(CaptionAssetEntry)) {
+        qWarning("CaptionAssetBundle: bundle is truncated");
+        return;
+    }
+    const auto tableEnd = sizeof(CaptionAssetHeader) +
+                          header->entryCount * sizeof(CaptionAssetEntry);
+    if (header->dataOffset < tableEnd || header->dataOffset > size) {
+        qWarning("CaptionAssetBundle: bundle is truncated");
+        return;
+    }
+    // Every image must lie within the data section, image() trusts them.
+    const auto dataSize = size - header->dataOffset;
+    const auto *entries = reinterpret_cast<const CaptionAssetEntry *>(
+        data + sizeof(CaptionAssetHeader));
+    for (quint32 i = 0; i < header->entryCount; ++i) {
+        const auto &entry = entries[i];
+        const auto format = static_cast<QImage::Format>(entry.format);
+        const auto depth = format == QImage::Format_Alpha8 ? 1u
+                           : format == QImage::Format_ARGB32_Premultiplied
+                               ? 4u
+                               : 0u;
+        const auto imageSize =
+            static_cast<std::size_t>(entry.bytesPerLine) * entry.height;
+        if (depth == 0 || entry.bytesPerLine < entry.width * depth ||
+            entry.offset > dataSize || imageSize > dataSize - entry.offset) {
+            qWarning("CaptionAssetBundle: entry %u lies outside the bundle",
+                     i);
+            return;
+        }
+    }
+    this->m_data = data;
+    this->m_entries = entries;
+    this->m_entryCount = header->entryCount;
+    this->m_dataOffset = header->dataOffset;
+}
+
+bool CaptionAssetBundle::isValid() const {
+    return this->m_data != nullptr;
+}
+
+QImage CaptionAssetBundle::image(quint32 key) const {
+    const auto *begin = this->m_entries;
+    const auto *end = this->m_entries + this->m_entryCount;
+    const auto *entry = std::lower_bound(
+        begin, end, key, [](const CaptionAssetEntry &lhs, quint32 rhs) {
+            return lhs.key < rhs;
+        });
+    if (entry == end || entry->key != key) {
+        return QImage();
+    }
+    // The const uchar * constructor keeps the image read-only; it points
+    // straight into the embedded bundle.
+    return QImage(this->m_data + this->m_dataOffset + entry->offset,
+                  entry->width,
+                  entry->height,
+                  entry->bytesPerLine,
+                  static_cast<QImage::Format>(entry->format));
+}
+
+} // namespace CSD::Internal
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "captionbuttonstyle.h"
+
+#include <QImage>
+#include <QtGlobal>
+
+#include <array>
+#include <cstddef>
+
+namespace CSD::Internal {
+
+// Layout of the caption icon bundle produced by tools/csdrasterize.cpp. The
+// bundle is a header, a table of entries sorted by key and a data section of
+// images aligned to 16 bytes. Tinted glyphs are stored as Format_Alpha8 masks,
+// full color artwork as Format_ARGB32_Premultiplied.
+constexpr quint32 kCaptionAssetMagic = 0x41445343; // "CSDA"
+constexpr quint32 kCaptionAssetVersion = 2;
+constexpr std::array<int, 5> kCaptionAssetScales = {100, 125, 150, 200, 300};
+
+struct CaptionAssetHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 entryCount;
+    quint32 dataOffset;
+};
+
+struct CaptionAssetEntry {
+    quint32 key;
+    quint16 width;
+    quint16 height;
+    quint32 offset;
+    quint16 format;
+    quint16 bytesPerLine;
+};
+
+// role is the numeric TitleBarButton::Role, states the CaptionButtonStates
+// bits and scale the device pixel ratio in percent.
+constexpr quint32 captionAssetKey(CaptionButtonStyle style,
+                                  quint32 role,
+                                  quint32 states,
+                                  quint32 scale) {
+    return static_cast<quint32>(style) | (role << 2u) | (states << 4u) |
+           (scale << 8u);
+}
+
+class CaptionAssetBundle {
+public:
+    static const CaptionAssetBundle &instance();
+
+    bool isValid() const;
+    // The returned image references the bundle memory without copying it.
+    // Its format is Format_Alpha8 for tintable glyphs.
+    QImage image(quint32 key) const;
+
+private:
+    CaptionAssetBundle(const uchar *data, std::size_t size);
+
+    const uchar *m_data = nullptr;
+    const CaptionAssetEntry *m_entries = nullptr;
+    quint32 m_entryCount = 0;
+    quint32 m_dataOffset = 0;
+};
+
+} // namespace CSD::Internal
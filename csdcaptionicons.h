@@ -0,0 +1,234 @@
+#pragma once
+
+#include "captionbuttonstyle.h"
+
+#include <QFlags>
+#include <QSize>
+#include <QStringView>
+
+#include <array>
+#include <cstddef>
+
+// Styles compiled into the binary. A disabled style keeps its metrics but
+// loses its icon table and, through CMake, its resources.
+#ifndef CSD_CAPTION_STYLE_CUSTOM
+#define CSD_CAPTION_STYLE_CUSTOM 1
+#endif
+#ifndef CSD_CAPTION_STYLE_WIN
+#define CSD_CAPTION_STYLE_WIN 1
+#endif
+#ifndef CSD_CAPTION_STYLE_MAC
+#define CSD_CAPTION_STYLE_MAC 1
+#endif
+
+namespace CSD::Internal {
+
+enum CaptionButtonState {
+    CaptionButtonActive = 0x1,
+    CaptionButtonMaximized = 0x2,
+    CaptionButtonHovered = 0x4,
+    CaptionButtonPressed = 0x8,
+};
+Q_DECLARE_FLAGS(CaptionButtonStates, CaptionButtonState)
+
+constexpr std::size_t kCaptionButtonStateCount = 16;
+
+struct CaptionIconPath {
+    const char16_t *data = nullptr;
+    std::size_t size = 0;
+
+    constexpr CaptionIconPath() = default;
+    template <std::size_t N>
+    constexpr CaptionIconPath(const char16_t (&path)[N])
+        : data(path), size(N - 1) {}
+
+    constexpr QStringView view() const {
+        return QStringView(data, static_cast<qsizetype>(size));
+    }
+};
+
+// Glyphs with a tone other than None are alpha masks that are tinted with the
+// title bar's color for that tone; None marks full color artwork.
+enum class CaptionGlyphTone : quint8 { None, Normal, Inactive, Highlight };
+
+struct CaptionIcon {
+    CaptionIconPath path;
+    CaptionGlyphTone tone = CaptionGlyphTone::None;
+
+    constexpr CaptionIcon() = default;
+    constexpr CaptionIcon(CaptionIconPath iconPath,
+                          CaptionGlyphTone iconTone = CaptionGlyphTone::None)
+        : path(iconPath), tone(iconTone) {}
+};
+
+// Indexed by the packed CaptionButtonStates bits, then by caption button
+// (minimize, maximize/restore, close).
+using CaptionIconTable =
+    std::array<std::array<CaptionIcon, 3>, kCaptionButtonStateCount>;
+
+constexpr CaptionIconTable chromeIconTable(CaptionIconPath minimize,
+                                           CaptionIconPath maximize,
+                                           CaptionIconPath restore,
+                                           CaptionIconPath close) {
+    auto table = CaptionIconTable{};
+    for (std::size_t state = 0; state < kCaptionButtonStateCount; ++state) {
+        const bool active = (state & CaptionButtonActive) != 0;
+        const bool maximized = (state & CaptionButtonMaximized) != 0;
+        const bool hovered = (state & CaptionButtonHovered) != 0;
+        const auto tone = active || hovered ? CaptionGlyphTone::Normal
+                                            : CaptionGlyphTone::Inactive;
+        table[state][0] = CaptionIcon(minimize, tone);
+        table[state][1] = CaptionIcon(maximized ? restore : maximize, tone);
+        table[state][2] =
+            CaptionIcon(close, hovered ? CaptionGlyphTone::Highlight : tone);
+    }
+    return table;
+}
+
+constexpr CaptionIconTable macIconTable() {
+    using Path = CaptionIconPath;
+    constexpr auto minimize = Path(u":/resources/titlebar/mac/minimize.png");
+    constexpr auto minimizeHovered =
+        Path(u":/resources/titlebar/mac/minimize-hovered.png");
+    constexpr auto minimizePressed =
+        Path(u":/resources/titlebar/mac/minimize-pressed.png");
+    constexpr auto maximizeRestore =
+        Path(u":/resources/titlebar/mac/maximize-restore.png");
+    constexpr auto maximizeHovered = Path(
+        u":/resources/titlebar/mac/maximize-restore-normal-hovered.png");
+    constexpr auto maximizePressed = Path(
+        u":/resources/titlebar/mac/maximize-restore-normal-pressed.png");
+    constexpr auto restoreHovered = Path(
+        u":/resources/titlebar/mac/maximize-restore-maximized-hovered.png");
+    constexpr auto restorePressed = Path(
+        u":/resources/titlebar/mac/maximize-restore-maximized-pressed.png");
+    constexpr auto close = Path(u":/resources/titlebar/mac/close.png");
+    constexpr auto closeHovered =
+        Path(u":/resources/titlebar/mac/close-hovered.png");
+    constexpr auto closePressed =
+        Path(u":/resources/titlebar/mac/close-pressed.png");
+    constexpr auto inactive = Path(u":/resources/titlebar/mac/inactive.png");
+
+    auto table = CaptionIconTable{};
+    for (std::size_t state = 0; state < kCaptionButtonStateCount; ++state) {
+        const bool active = (state & CaptionButtonActive) != 0;
+        const bool maximized = (state & CaptionButtonMaximized) != 0;
+        const bool hovered = (state & CaptionButtonHovered) != 0;
+        const bool pressed = (state & CaptionButtonPressed) != 0;
+        if (pressed) {
+            table[state] = {minimizePressed,
+                            maximized ? restorePressed : maximizePressed,
+                            closePressed};
+        } else if (hovered) {
+            table[state] = {minimizeHovered,
+                            maximized ? restoreHovered : maximizeHovered,
+                            closeHovered};
+        } else if (active) {
+            table[state] = {minimize, maximizeRestore, close};
+        } else {
+            table[state] = {inactive, inactive, inactive};
+        }
+    }
+    return table;
+}
+
+template <CaptionButtonStyle Style> struct CaptionStylePolicy;
+
+template <> struct CaptionStylePolicy<CaptionButtonStyle::custom> {
+    static constexpr bool enabled = CSD_CAPTION_STYLE_CUSTOM != 0;
+    static constexpr int buttonWidth = 30;
+    static constexpr int iconSize = 12;
+    static constexpr CaptionIconTable icons =
+        chromeIconTable(u":/resources/titlebar/custom/chrome-minimize.svg",
+                        u":/resources/titlebar/custom/chrome-maximize.svg",
+                        u":/resources/titlebar/custom/chrome-restore.svg",
+                        u":/resources/titlebar/custom/chrome-close.svg");
+};
+
+template <> struct CaptionStylePolicy<CaptionButtonStyle::win> {
+    static constexpr bool enabled = CSD_CAPTION_STYLE_WIN != 0;
+    static constexpr int buttonWidth = 46;
+    static constexpr int iconSize = 12;
+    static constexpr CaptionIconTable icons =
+        chromeIconTable(u":/resources/titlebar/win/chrome-minimize.svg",
+                        u":/resources/titlebar/win/chrome-maximize.svg",
+                        u":/resources/titlebar/win/chrome-restore.svg",
+                        u":/resources/titlebar/win/chrome-close.svg");
+};
+
+template <> struct CaptionStylePolicy<CaptionButtonStyle::mac> {
+    static constexpr bool enabled = CSD_CAPTION_STYLE_MAC != 0;
+    static constexpr int buttonWidth = 26;
+    static constexpr int iconSize = 16;
+    static constexpr CaptionIconTable icons = macIconTable();
+};
+
+struct CaptionStyleInfo {
+    int buttonWidth;
+    int iconSize;
+    // nullptr when the style is compiled out.
+    const CaptionIconTable *icons;
+};
+
+template <CaptionButtonStyle Style>
+constexpr CaptionStyleInfo makeCaptionStyleInfo() {
+    using Policy = CaptionStylePolicy<Style>;
+    if constexpr (Policy::enabled) {
+        return {Policy::buttonWidth, Policy::iconSize, &Policy::icons};
+    } else {
+        return {Policy::buttonWidth, Policy::iconSize, nullptr};
+    }
+}
+
+// Indexed by CaptionButtonStyle.
+constexpr std::array<CaptionStyleInfo, 3> kCaptionStyles = {
+    makeCaptionStyleInfo<CaptionButtonStyle::custom>(),
+    makeCaptionStyleInfo<CaptionButtonStyle::win>(),
+    makeCaptionStyleInfo<CaptionButtonStyle::mac>(),
+};
+
+constexpr const CaptionStyleInfo &captionStyleInfo(CaptionButtonStyle style) {
+    return kCaptionStyles[static_cast<std::size_t>(style)];
+}
+
+inline QSize captionIconSize(CaptionButtonStyle style) {
+    const auto size = captionStyleInfo(style).iconSize;
+    return QSize(size, size);
+}
+
+// button is 0 for minimize, 1 for maximize/restore and 2 for close.
+constexpr CaptionIcon captionIcon(CaptionButtonStyle style,
+                                  std::size_t button,
+                                  CaptionButtonStates states) {
+    const auto *icons = captionStyleInfo(style).icons;
+    if (icons == nullptr) {
+        return CaptionIcon();
+    }
+    return (*icons)[static_cast<std::size_t>(states)][button];
+}
+
+constexpr QStringView captionIconPath(CaptionButtonStyle style,
+                                      std::size_t button,
+                                      CaptionButtonStates states) {
+    return captionIcon(style, button, states).path.view();
+}
+
+inline std::array<QStringView, 3>
+captionIconPathsForState(bool active,
+                         bool maximized,
+                         bool hovered,
+                         bool pressed,
+                         CaptionButtonStyle style) {
+    auto states = CaptionButtonStates();
+    states.setFlag(CaptionButtonActive, active);
+    states.setFlag(CaptionButtonMaximized, maximized);
+    states.setFlag(CaptionButtonHovered, hovered);
+    states.setFlag(CaptionButtonPressed, pressed);
+    return {captionIconPath(style, 0, states),
+            captionIconPath(style, 1, states),
+            captionIconPath(style, 2, states)};
+}
+
+} // namespace CSD::Internal
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(CSD::Internal::CaptionButtonStates)
@@ -0,0 +1,405 @@
+#include "csddecorationmanager.h"
+
+#include "csdpaintedtitlebar.h"
+#include "csdtitlebar.h"
+
+#ifdef _WIN32
+#include "win32csd.h"
+#else
+#include "linuxcsd.h"
+#endif
+
+#include <QApplication>
+#include <QDockWidget>
+#include <QEvent>
+#include <QWidget>
+
+#include <algorithm>
+#include <functional>
+
+namespace CSD {
+
+// Whether prepare() makes windows frameless; see there.
+#ifdef _WIN32
+static constexpr bool kPreparedFrameless = false;
+#else
+static constexpr bool kPreparedFrameless = true;
+#endif
+
+// The first element of pairs, sorted by the address in their first member,
+// not less than key.
+template <typename Pairs>
+static auto lowerBoundByFirst(Pairs &pairs, const void *key) {
+    return std::lower_bound(pairs.begin(),
+                            pairs.end(),
+                            key,
+                            [](const auto &pair, const void *rhs) {
+                                return std::less<const void *>()(pair.first,
+                                                                 rhs);
+                            });
+}
+
+// The side of a title bar the manager created that the platform filter
+// talks to, or null.
+static Internal::TitleBarClient *titleBarClient(QWidget *widget) {
+    auto *titleBar = qobject_cast<TitleBar *>(widget);
+    if (titleBar != nullptr) {
+        return titleBar;
+    }
+    return qobject_cast<PaintedTitleBar *>(widget);
+}
+
+DecorationManager::DecorationManager(QObject *parent)
+    : QObject(parent), m_filter(new Filter(this)),
+#ifdef _WIN32
+      m_captionButtonStyle(CaptionButtonStyle::win)
+#else
+      m_captionButtonStyle(CaptionButtonStyle::custom)
+#endif
+{
+    this->m_filter->setFiltersApplication(true);
+    QCoreApplication::instance()->installNativeEventFilter(this->m_filter);
+    QCoreApplication::instance()->installEventFilter(this);
+}
+
+DecorationManager *DecorationManager::instance() {
+    static auto *manager =
+        new DecorationManager(QCoreApplication::instance());
+    return manager;
+}
+
+DecoratedWindows DecorationManager::decoratedWindows() const {
+    return this->m_decoratedWindows;
+}
+
+void DecorationManager::setDecoratedWindows(
+    DecoratedWindows decoratedWindows) {
+    this->m_decoratedWindows = decoratedWindows;
+}
+
+CaptionButtonStyle DecorationManager::captionButtonStyle() const {
+    return this->m_captionButtonStyle;
+}
+
+void DecorationManager::setCaptionButtonStyle(
+    CaptionButtonStyle captionButtonStyle) {
+    this->m_captionButtonStyle = captionButtonStyle;
+}
+
+TitleBarKind DecorationManager::titleBarKind() const {
+    return this->m_titleBarKind;
+}
+
+void DecorationManager::setTitleBarKind(TitleBarKind titleBarKind) {
+    this->m_titleBarKind = titleBarKind;
+}
+
+int DecorationManager::shadowRadius() const {
+    return this->m_shadowRadius;
+}
+
+void DecorationManager::setShadowRadius(int radius) {
+    this->m_shadowRadius = qMax(0, radius);
+}
+
+QWidget *DecorationManager::titleBarWidget(const QWidget *window) const {
+    const auto found = lowerBoundByFirst(this->m_titleBars, window);
+    if (found == this->m_titleBars.end() || found->first != window) {
+        return nullptr;
+    }
+    return found->second;
+}
+
+TitleBar *DecorationManager::titleBar(const QWidget *window) const {
+    return qobject_cast<TitleBar *>(this->titleBarWidget(window));
+}
+
+bool DecorationManager::eventFilter(QObject *watched, QEvent *event) {
+    // Every event of the application passes here, most leave after the
+    // switch on their type.
+    switch (event->type()) {
+    case QEvent::Create:
+        // Sent by QWidget's constructor.
+        if (watched->isWidgetType()) {
+            this->prepare(static_cast<QWidget *>(watched));
+        }
+        break;
+    case QEvent::Polish:
+        if (watched->isWidgetType()) {
+            this->decorate(static_cast<QWidget *>(watched));
+        }
+        break;
+    case QEvent::ParentChange:
+        // Widgets created without a parent are often given one before they
+        // are shown, setCentralWidget() among others.
+        if (!this->m_pending.empty() && watched->isWidgetType() &&
+            !static_cast<QWidget *>(watched)->isWindow()) {
+            this->unprepare(static_cast<QWidget *>(watched));
+        }
+        break;
+    case QEvent::Resize:
+    case QEvent::ContentsRectChange:
+        if (watched->isWidgetType() &&
+            static_cast<QWidget *>(watched)->isWindow()) {
+            auto *window = static_cast<QWidget *>(watched);
+            auto *titleBar = this->titleBarWidget(window);
+            if (titleBar != nullptr) {
+                placeTitleBar(window, titleBar);
+            }
+        }
+        break;
+    case QEvent::ActivationChange:
+        // Decorated windows hear about it from the platform filter, docks
+        // are told here.
+        if (this->m_decoratedWindows & DecoratedFloatingDocks) {
+            auto *dock = qobject_cast<QDockWidget *>(watched);
+            auto *titleBar = dock != nullptr
+                                 ? titleBarClient(dock->titleBarWidget())
+                                 : nullptr;
+            if (titleBar != nullptr) {
+                titleBar->setActive(dock->isActiveWindow());
+            }
+        }
+        break;
+    default:
+        break;
+    }
+    return this->m_filter->eventFilter(watched, event);
+}
+
+bool DecorationManager::isDecoratedType(const QWidget *widget) const {
+    switch (widget->windowType()) {
+    case Qt::Window:
+        return this->m_decoratedWindows & DecoratedMainWindows;
+    case Qt::Dialog:
+        return this->m_decoratedWindows & DecoratedDialogs;
+    default:
+        return false;
+    }
+}
+
+void DecorationManager::prepare(QWidget *widget) {
+    if (!widget->isWindow() || !this->isDecoratedType(widget) ||
+        widget->windowFlags().testFlag(Qt::FramelessWindowHint)) {
+        return;
+    }
+    auto changes = PreparedChanges();
+#ifndef _WIN32
+    // There is no window system window yet to tell, which is what the Linux
+    // filter's setWindowFlag() would do later. Done now, it finds the flag
+    // set and leaves the window alone. On Windows the window keeps its
+    // native frame: the Win32 filter extends the client area over it
+    // through the custom margins instead.
+    widget->overrideWindowFlags(widget->windowFlags() |
+                                Qt::FramelessWindowHint);
+    // The window's visual is picked when it is created.
+    if (this->m_shadowRadius > 0 &&
+        !widget->testAttribute(Qt::WA_TranslucentBackground)) {
+        // Which also sets WA_NoSystemBackground.
+        changes.translucent = true;
+        changes.hadNoSystemBackground =
+            widget->testAttribute(Qt::WA_NoSystemBackground);
+        widget->setAttribute(Qt::WA_TranslucentBackground);
+    }
+#endif
+    this->m_pending.emplace(
+        lowerBoundByFirst(this->m_pending, widget), widget, changes);
+    connect(widget,
+            &QObject::destroyed,
+            this,
+            &DecorationManager::forgetWindow);
+}
+
+void DecorationManager::unprepare(QWidget *widget) {
+    const auto found = lowerBoundByFirst(this->m_pending, widget);
+    if (found == this->m_pending.end() || found->first != widget) {
+        return;
+    }
+    const auto changes = found->second;
+    this->m_pending.erase(found);
+#ifndef _WIN32
+    widget->overrideWindowFlags(widget->windowFlags() &
+                                ~Qt::FramelessWindowHint);
+#endif
+    if (changes.translucent) {
+        widget->setAttribute(Qt::WA_TranslucentBackground, false);
+        widget->setAttribute(Qt::WA_NoSystemBackground,
+                             changes.hadNoSystemBackground);
+    }
+    disconnect(widget,
+               &QObject::destroyed,
+               this,
+               &DecorationManager::forgetWindow);
+}
+
+void DecorationManager::decorate(QWidget *widget) {
+    const auto found = lowerBoundByFirst(this->m_pending, widget);
+    if (found == this->m_pending.end() || found->first != widget) {
+        if (this->m_decoratedWindows & DecoratedFloatingDocks) {
+            auto *dock = qobject_cast<QDockWidget *>(widget);
+            if (dock != nullptr) {
+                // A docked dock is part of its main window; only a floating
+                // one is a window of its own to decorate.
+                connect(dock,
+                        &QDockWidget::topLevelChanged,
+                        this,
+                        &DecorationManager::dockTopLevelChanged,
+                        Qt::UniqueConnection);
+                if (dock->isFloating()) {
+                    this->decorateDock(dock);
+                }
+            }
+        }
+        return;
+    }
+    this->m_pending.erase(found);
+    // Unless the application changed the flags prepare() left.
+    if (!widget->isWindow() ||
+        widget->windowFlags().testFlag(Qt::FramelessWindowHint) !=
+            kPreparedFrameless) {
+        return;
+    }
+    if (this->m_titleBarKind == TitleBarKind::painted) {
+        this->decorateWith<PaintedTitleBar>(widget);
+    } else {
+        this->decorateWith<TitleBar>(widget);
+    }
+}
+
+template <typename T> void DecorationManager::decorateWith(QWidget *widget) {
+    auto *titleBar = new T(this->m_captionButtonStyle, QIcon(), widget);
+    const bool dialog = widget->windowType() == Qt::Dialog;
+    const auto flags = widget->windowFlags();
+    titleBar->setMinimizable(!dialog ||
+                             flags.testFlag(Qt::WindowMinimizeButtonHint));
+    titleBar->setMaximizable(!dialog ||
+                             flags.testFlag(Qt::WindowMaximizeButtonHint));
+    titleBar->setActive(widget->isActiveWindow());
+    titleBar->onWindowStateChange(widget->windowState());
+    connect(titleBar,
+            &T::minimizeClicked,
+            this,
+            &DecorationManager::minimizeWindow);
+    connect(titleBar,
+            &T::maximizeRestoreClicked,
+            this,
+            &DecorationManager::toggleMaximized);
+    connect(titleBar,
+            &T::closeClicked,
+            this,
+            &DecorationManager::closeWindow);
+    this->m_titleBars.emplace(
+        lowerBoundByFirst(this->m_titleBars, widget), widget, titleBar);
+
+    const auto margins = widget->contentsMargins();
+    widget->setContentsMargins(margins.left(),
+                               margins.top() + titleBar->sizeHint().height(),
+                               margins.right(),
+                               margins.bottom());
+    placeTitleBar(widget, titleBar);
+    this->m_filter->apply(widget, titleBar);
+#ifndef _WIN32
+    if (this->m_shadowRadius > 0) {
+        this->m_filter->setShadow(widget, this->m_shadowRadius);
+    }
+#endif
+}
+
+void DecorationManager::decorateDock(QDockWidget *dock) {
+    if (dock->titleBarWidget() != nullptr) {
+        return;
+    }
+    if (this->m_titleBarKind == TitleBarKind::painted) {
+        this->decorateDockWith<PaintedTitleBar>(dock);
+    } else {
+        this->decorateDockWith<TitleBar>(dock);
+    }
+    this->m_dockTitleBars.emplace(
+        lowerBoundByFirst(this->m_dockTitleBars, dock),
+        dock,
+        dock->titleBarWidget());
+    connect(dock,
+            &QObject::destroyed,
+            this,
+            &DecorationManager::forgetWindow,
+            Qt::UniqueConnection);
+}
+
+template <typename T>
+void DecorationManager::decorateDockWith(QDockWidget *dock) {
+    auto *titleBar = new T(this->m_captionButtonStyle, QIcon(), dock);
+    titleBar->setMinimizable(false);
+    titleBar->setMaximizable(false);
+    titleBar->setActive(dock->isActiveWindow());
+    connect(titleBar,
+            &T::closeClicked,
+            this,
+            &DecorationManager::closeWindow);
+    dock->setTitleBarWidget(titleBar);
+}
+
+void DecorationManager::undecorateDock(QDockWidget *dock) {
+    const auto found = lowerBoundByFirst(this->m_dockTitleBars, dock);
+    if (found == this->m_dockTitleBars.end() || found->first != dock) {
+        return;
+    }
+    auto *titleBar = found->second;
+    this->m_dockTitleBars.erase(found);
+    if (dock->titleBarWidget() == titleBar) {
+        dock->setTitleBarWidget(nullptr);
+    }
+    // It may still be handling the drag that docked the dock.
+    titleBar->deleteLater();
+}
+
+void DecorationManager::dockTopLevelChanged(bool floating) {
+    auto *dock = static_cast<QDockWidget *>(this->sender());
+    if (floating) {
+        this->decorateDock(dock);
+    } else {
+        this->undecorateDock(dock);
+    }
+}
+
+void DecorationManager::placeTitleBar(QWidget *window, QWidget *titleBar) {
+    const auto contents = window->contentsRect();
+    const auto height = titleBar->sizeHint().height();
+    titleBar->setGeometry(
+        contents.left(), contents.top() - height, contents.width(), height);
+}
+
+void DecorationManager::forgetWindow(QObject *object) {
+    // Only the address is left of the window by now.
+    const auto pending = lowerBoundByFirst(this->m_pending, object);
+    if (pending != this->m_pending.end() &&
+        static_cast<QObject *>(pending->first) == object) {
+        this->m_pending.erase(pending);
+    }
+    const auto titleBar = lowerBoundByFirst(this->m_titleBars, object);
+    if (titleBar != this->m_titleBars.end() &&
+        static_cast<QObject *>(titleBar->first) == object) {
+        this->m_titleBars.erase(titleBar);
+    }
+    const auto dock = lowerBoundByFirst(this->m_dockTitleBars, object);
+    if (dock != this->m_dockTitleBars.end() &&
+        static_cast<QObject *>(dock->first) == object) {
+        this->m_dockTitleBars.erase(dock);
+    }
+}
+
+// The title bars are children of the window or dock they decorate.
+void DecorationManager::minimizeWindow() {
+    auto *window = static_cast<QWidget *>(this->sender())->parentWidget();
+    window->setWindowState(window->windowState() | Qt::WindowMinimized);
+}
+
+void DecorationManager::toggleMaximized() {
+    auto *window = static_cast<QWidget *>(this->sender())->parentWidget();
+    window->setWindowState(window->windowState() ^ Qt::WindowMaximized);
+}
+
+void DecorationManager::closeWindow() {
+    static_cast<QWidget *>(this->sender())->parentWidget()->close();
+}
+
+} // namespace CSD
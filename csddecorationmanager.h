@@ -0,0 +1,124 @@
+#pragma once
+
+#include "captionbuttonstyle.h"
+
+#include <QFlags>
+#include <QObject>
+
+#include <utility>
+#include <vector>
+
+class QDockWidget;
+class QWidget;
+
+namespace CSD {
+
+namespace Internal {
+#ifdef _WIN32
+class Win32ClientSideDecorationFilter;
+#else
+class LinuxClientSideDecorationFilter;
+#endif
+} // namespace Internal
+
+class TitleBar;
+
+enum DecoratedWindow {
+    // Top-level windows of type Qt::Window, QMainWindow among them.
+    DecoratedMainWindows = 0x1,
+    // Top-level windows of type Qt::Dialog.
+    DecoratedDialogs = 0x2,
+    // QDockWidget gets a title bar widget while it floats, which Qt shows in
+    // place of the native frame. It is removed again when the dock docks.
+    DecoratedFloatingDocks = 0x4,
+};
+Q_DECLARE_FLAGS(DecoratedWindows, DecoratedWindow)
+
+enum class TitleBarKind {
+    // TitleBar, a layout holding a widget per caption button.
+    widgets,
+    // PaintedTitleBar, a single widget that paints its caption buttons.
+    painted,
+};
+
+// Decorates every matching top-level window as it is created, from a single
+// event filter on the application. Windows are picked by their type when
+// QWidget's constructor announces them, before their window system window
+// exists, and get a title bar once polished. Those given a parent in between
+// are restored and left alone. The title bar sits in the window's top
+// contents margin rather than in a layout. Nothing is allocated
+// per window beyond the title bar: the platform filter updates it directly
+// and its buttons are connected to the manager.
+class DecorationManager : public QObject {
+    Q_OBJECT
+
+private:
+#ifdef _WIN32
+    using Filter = Internal::Win32ClientSideDecorationFilter;
+#else
+    using Filter = Internal::LinuxClientSideDecorationFilter;
+#endif
+    Filter *m_filter;
+    DecoratedWindows m_decoratedWindows;
+    CaptionButtonStyle m_captionButtonStyle;
+    TitleBarKind m_titleBarKind = TitleBarKind::widgets;
+    int m_shadowRadius = 0;
+    // What prepare() changed on a window, undone if it becomes a child
+    // before it is polished.
+    struct PreparedChanges {
+        bool translucent = false;
+        bool hadNoSystemBackground = false;
+    };
+    // Both sorted by address. Windows prepared on construction wait in
+    // m_pending for their Polish event.
+    std::vector<std::pair<QWidget *, PreparedChanges>> m_pending;
+    std::vector<std::pair<QWidget *, QWidget *>> m_titleBars;
+    // The floating docks the manager gave a title bar, sorted by address.
+    std::vector<std::pair<QDockWidget *, QWidget *>> m_dockTitleBars;
+
+    explicit DecorationManager(QObject *parent);
+
+    bool isDecoratedType(const QWidget *widget) const;
+    void prepare(QWidget *widget);
+    void unprepare(QWidget *widget);
+    void decorate(QWidget *widget);
+    template <typename T> void decorateWith(QWidget *widget);
+    void decorateDock(QDockWidget *dock);
+    template <typename T> void decorateDockWith(QDockWidget *dock);
+    void undecorateDock(QDockWidget *dock);
+    void dockTopLevelChanged(bool floating);
+    static void placeTitleBar(QWidget *window, QWidget *titleBar);
+    void forgetWindow(QObject *object);
+    void minimizeWindow();
+    void toggleMaximized();
+    void closeWindow();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+public:
+    // The manager of the running application, created on first use.
+    static DecorationManager *instance();
+
+    // Kinds of windows decorated from now on; none by default.
+    DecoratedWindows decoratedWindows() const;
+    void setDecoratedWindows(DecoratedWindows decoratedWindows);
+    CaptionButtonStyle captionButtonStyle() const;
+    void setCaptionButtonStyle(CaptionButtonStyle captionButtonStyle);
+    // The title bar windows decorated from now on get; widgets by default.
+    TitleBarKind titleBarKind() const;
+    void setTitleBarKind(TitleBarKind titleBarKind);
+    // Radius of the shadow drawn around windows decorated from now on. Only
+    // used on X11 with a compositing manager.
+    int shadowRadius() const;
+    void setShadowRadius(int radius);
+
+    // The title bar the manager gave window, or null. titleBar() is also
+    // null when the title bar is a PaintedTitleBar.
+    QWidget *titleBarWidget(const QWidget *window) const;
+    TitleBar *titleBar(const QWidget *window) const;
+};
+
+} // namespace CSD
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(CSD::DecoratedWindows)
@@ -0,0 +1,107 @@
+#include "csdfadedriver.h"
+
+#include <algorithm>
+
+namespace CSD::Internal {
+
+HoverFadeDriver &HoverFadeDriver::instance() {
+    static auto *driver = new HoverFadeDriver();
+    return *driver;
+}
+
+void HoverFadeDriver::fadeTo(FadeClient *client,
+                             int slot,
+                             double target,
+                             int duration) {
+    const auto step = 1.0 / std::max(duration, 1);
+    auto it = std::find_if(this->m_fades.begin(),
+                           this->m_fades.end(),
+                           [client, slot](const Fade &f) {
+                               return f.client == client && f.slot == slot;
+                           });
+    if (it != this->m_fades.end()) {
+        it->target = target;
+        it->step = step;
+        ++this->m_retargetedFades;
+        return;
+    }
+    if (qFuzzyIsNull(client->fadeValue(slot) - target)) {
+        return;
+    }
+    this->m_fades.push_back(Fade{client, slot, target, step});
+    this->m_peakLiveFades =
+        std::max(this->m_peakLiveFades, this->liveFades());
+    if (this->state() != QAbstractAnimation::Running) {
+        this->m_lastTime = 0;
+        this->start();
+    }
+}
+
+void HoverFadeDriver::cancel(FadeClient *client) {
+    this->m_fades.erase(
+        std::remove_if(this->m_fades.begin(),
+                       this->m_fades.end(),
+                       [client](const Fade &f) { return f.client == client; }),
+        this->m_fades.end());
+    if (this->m_fades.empty()) {
+        this->stop();
+    }
+}
+
+void HoverFadeDriver::settle(FadeClient *client) {
+    auto settled = std::vector<Fade>();
+    for (const auto &fade : this->m_fades) {
+        if (fade.client == client) {
+            settled.push_back(fade);
+        }
+    }
+    if (settled.empty()) {
+        return;
+    }
+    this->cancel(client);
+    for (const auto &fade : settled) {
+        client->setFadeValue(fade.slot, fade.target);
+    }
+}
+
+int HoverFadeDriver::duration() const {
+    return -1;
+}
+
+int HoverFadeDriver::liveFades() const {
+    return static_cast<int>(this->m_fades.size());
+}
+
+int HoverFadeDriver::peakLiveFades() const {
+    return this->m_peakLiveFades;
+}
+
+quint64 HoverFadeDriver::retargetedFades() const {
+    return this->m_retargetedFades;
+}
+
+void HoverFadeDriver::updateCurrentTime(int currentTime) {
+    const auto elapsed = currentTime - this->m_lastTime;
+    this->m_lastTime = currentTime;
+    if (elapsed <= 0) {
+        return;
+    }
+    auto live = this->m_fades.begin();
+    for (const auto &fade : this->m_fades) {
+        const auto current = fade.client->fadeValue(fade.slot);
+        const auto delta = fade.step * static_cast<double>(elapsed);
+        const auto next = current < fade.target
+                              ? std::min(current + delta, fade.target)
+                              : std::max(current - delta, fade.target);
+        fade.client->setFadeValue(fade.slot, next);
+        if (!qFuzzyIsNull(next - fade.target)) {
+            *live++ = fade;
+        }
+    }
+    this->m_fades.erase(live, this->m_fades.end());
+    if (this->m_fades.empty()) {
+        this->stop();
+    }
+}
+
+} // namespace CSD::Internal
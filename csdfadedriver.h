@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QAbstractAnimation>
+
+#include <vector>
+
+namespace CSD::Internal {
+
+// Implemented by whatever owns fading values. A client can own several
+// independent fades, told apart by slot.
+class FadeClient {
+public:
+    virtual double fadeValue(int slot) const = 0;
+    virtual void setFadeValue(int slot, double value) = 0;
+
+protected:
+    ~FadeClient() = default;
+};
+
+// Drives the hover fades of every caption button in the process from a single
+// animation, so all running fades advance on the same frame-aligned tick of
+// Qt's animation timer. A slot has at most one fade; asking for a new target
+// while it is fading retargets it from its current value.
+class HoverFadeDriver : public QAbstractAnimation {
+    Q_OBJECT
+
+public:
+    static HoverFadeDriver &instance();
+
+    // duration is the time a full 0 to 1 fade takes, shorter distances take
+    // proportionally less.
+    void fadeTo(FadeClient *client,
+                int slot,
+                double target,
+                int duration = 125);
+    // Both act on every slot of client.
+    void cancel(FadeClient *client);
+    // Ends running fades at their target right away.
+    void settle(FadeClient *client);
+
+    int duration() const override;
+
+    int liveFades() const;
+    int peakLiveFades() const;
+    quint64 retargetedFades() const;
+
+protected:
+    void updateCurrentTime(int currentTime) override;
+
+private:
+    HoverFadeDriver() = default;
+
+    struct Fade {
+        FadeClient *client;
+        int slot;
+        double target;
+        double step; // per millisecond
+    };
+
+    std::vector<Fade> m_fades;
+    int m_lastTime = 0;
+    int m_peakLiveFades = 0;
+    quint64 m_retargetedFades = 0;
+};
+
+} // namespace CSD::Internal
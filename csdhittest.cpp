@@ -0,0 +1,44 @@
+#include "csdhittest.h"
+
+#include "csdresizeedges.h"
+
+namespace CSD::Internal {
+
+void HitTestMap::setFrame(const QSize &windowSize,
+                          int inset,
+                          bool resizeWidth,
+                          bool resizeHeight) {
+    this->m_windowSize = windowSize;
+    this->m_inset = inset;
+    this->m_resizeWidth = resizeWidth;
+    this->m_resizeHeight = resizeHeight;
+}
+
+void HitTestMap::setCaption(
+    const QRect &caption, const std::array<QRect, kMaxCaptionHoles> &holes) {
+    this->m_caption = caption;
+    this->m_captionHoles = holes;
+}
+
+HitTestResult HitTestMap::hitTest(const QPoint &pos) const {
+    const auto inset = this->m_inset;
+    const auto edges = resizeEdgesAt(
+        pos - QPoint(inset, inset),
+        this->m_windowSize - QSize(2 * inset, 2 * inset),
+        this->m_resizeWidth,
+        this->m_resizeHeight);
+    if (edges) {
+        return {WindowArea::ResizeBorder, edges};
+    }
+    if (!this->m_caption.contains(pos)) {
+        return {};
+    }
+    for (const auto &hole : this->m_captionHoles) {
+        if (hole.contains(pos)) {
+            return {};
+        }
+    }
+    return {WindowArea::Caption, Qt::Edges()};
+}
+
+} // namespace CSD::Internal
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QPoint>
+#include <QRect>
+#include <QSize>
+
+#include <array>
+#include <cstddef>
+
+namespace CSD::Internal {
+
+// What a point of a decorated window is part of. Client is anything the
+// window handles itself, caption buttons and the menu bar included.
+enum class WindowArea { Client, Caption, ResizeBorder };
+
+struct HitTestResult {
+    WindowArea area = WindowArea::Client;
+    // The edges a resize started there would move, for ResizeBorder.
+    Qt::Edges edges;
+};
+
+// The areas of a decorated window, in its logical coordinates. The platform
+// filter sets the frame on resize and window state changes, the title bar
+// the caption whenever it is laid out. hitTest() then only compares the
+// point to a handful of rectangles, it neither allocates nor asks the window
+// system for anything.
+class HitTestMap {
+public:
+    // Parts of the caption that belong to the client: the caption buttons,
+    // the caption icon and the menu bar.
+    static constexpr std::size_t kMaxCaptionHoles = 4;
+
+    // inset is the part of the window around the content that is not even
+    // the resize border, such as the outer band of a shadow.
+    void setFrame(const QSize &windowSize,
+                  int inset,
+                  bool resizeWidth,
+                  bool resizeHeight);
+    void setCaption(const QRect &caption,
+                    const std::array<QRect, kMaxCaptionHoles> &holes);
+
+    HitTestResult hitTest(const QPoint &pos) const;
+
+private:
+    QSize m_windowSize;
+    int m_inset = 0;
+    bool m_resizeWidth = false;
+    bool m_resizeHeight = false;
+    QRect m_caption;
+    // Null rectangles are unused.
+    std::array<QRect, kMaxCaptionHoles> m_captionHoles;
+};
+
+} // namespace CSD::Internal
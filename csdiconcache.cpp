@@ -0,0 +1,165 @@
+#include "csdiconcache.h"
+
+#include "csdcaptionassets.h"
+#include "csdtint.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QImageReader>
+
+#include <algorithm>
+#include <cmath>
+
+namespace CSD::Internal {
+
+static void clearCaptionIconCache() {
+    CaptionIconCache::instance().clear();
+}
+
+CaptionIconCache &CaptionIconCache::instance() {
+    static auto *cache = []() {
+        // Rendered images must not outlive the application object, so drop
+        // them while it is still around instead of at static destruction.
+        qAddPostRoutine(clearCaptionIconCache);
+        return new CaptionIconCache();
+    }();
+    return *cache;
+}
+
+QImage CaptionIconCache::image(CaptionButtonStyle style,
+                              TitleBarButton::Role role,
+                              CaptionButtonStates states,
+                              qreal devicePixelRatio,
+                              QRgb tint) {
+    if (role == TitleBarButton::CaptionIcon) {
+        return QImage();
+    }
+    const auto tone =
+        captionIcon(style, static_cast<std::size_t>(role) - 1, states).tone;
+    if (tone == CaptionGlyphTone::None) {
+        tint = 0;
+    }
+    const auto scale =
+        static_cast<quint32>(std::lround(devicePixelRatio * 100.0));
+    const auto assetKey = captionAssetKey(style,
+                                          static_cast<quint32>(role),
+                                          static_cast<quint32>(states),
+                                          scale);
+    const auto cacheKey =
+        static_cast<quint64>(assetKey) | (static_cast<quint64>(tint) << 32u);
+    auto it = this->m_images.constFind(cacheKey);
+    if (it != this->m_images.constEnd()) {
+        ++this->m_hits;
+        return *it;
+    }
+    ++this->m_misses;
+
+    auto image = QImage();
+    if (tone == CaptionGlyphTone::None) {
+        image = CaptionAssetBundle::instance().image(assetKey);
+        if (image.isNull()) {
+            image = render(style, role, states, devicePixelRatio);
+        }
+    } else {
+        const auto alpha =
+            this->mask(assetKey, style, role, states, devicePixelRatio);
+        if (!alpha.isNull()) {
+            image = QImage(alpha.size(), QImage::Format_ARGB32_Premultiplied);
+            tintAlphaMask(alpha, tint, image);
+        }
+    }
+    this->m_images.insert(cacheKey, image);
+    return image;
+}
+
+void CaptionIconCache::clear() {
+    this->m_images.clear();
+    this->m_masks.clear();
+}
+
+quint64 CaptionIconCache::hits() const {
+    return this->m_hits;
+}
+
+quint64 CaptionIconCache::misses() const {
+    return this->m_misses;
+}
+
+QImage CaptionIconCache::mask(quint32 assetKey,
+                               CaptionButtonStyle style,
+                               TitleBarButton::Role role,
+                               CaptionButtonStates states,
+                               qreal devicePixelRatio) {
+    auto it = this->m_masks.constFind(assetKey);
+    if (it != this->m_masks.constEnd()) {
+        return *it;
+    }
+    auto alpha = CaptionAssetBundle::instance().image(assetKey);
+    if (alpha.format() != QImage::Format_Alpha8) {
+        alpha = render(style, role, states, devicePixelRatio)
+                    .convertToFormat(QImage::Format_Alpha8);
+    }
+    this->m_masks.insert(assetKey, alpha);
+    return alpha;
+}
+
+QImage CaptionIconCache::render(CaptionButtonStyle style,
+                                TitleBarButton::Role role,
+                                CaptionButtonStates states,
+                                qreal devicePixelRatio) {
+    if (role == TitleBarButton::CaptionIcon) {
+        return QImage();
+    }
+
+    const auto logicalSize = captionIconSize(style);
+    const auto deviceSize =
+        QSize(static_cast<int>(std::lround(logicalSize.width() *
+                                           devicePixelRatio)),
+              static_cast<int>(std::lround(logicalSize.height() *
+                                           devicePixelRatio)));
+
+#ifdef CSD_HAVE_CAPTION_ASSETS
+    // Builds with the bundle leave the icon resources out. A scale it lacks
+    // is scaled down from the closest larger one it has, or up from the
+    // largest.
+    const auto scale = std::lround(devicePixelRatio * 100.0);
+    const auto source = std::find_if(kCaptionAssetScales.begin(),
+                                     kCaptionAssetScales.end(),
+                                     [scale](int s) { return s >= scale; });
+    const auto sourceScale = source != kCaptionAssetScales.end()
+                                 ? *source
+                                 : kCaptionAssetScales.back();
+    const auto image = CaptionAssetBundle::instance().image(
+        captionAssetKey(style,
+                        static_cast<quint32>(role),
+                        static_cast<quint32>(states),
+                        static_cast<quint32>(sourceScale)));
+    if (image.isNull()) {
+        return QImage();
+    }
+    return image.convertToFormat(QImage::Format_ARGB32_Premultiplied)
+        .scaled(deviceSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+#else
+    auto path =
+        captionIconPath(style, static_cast<std::size_t>(role) - 1, states)
+            .toString();
+    if (path.isEmpty()) {
+        return QImage();
+    }
+
+    if (devicePixelRatio > 1.0 && path.endsWith(QLatin1String(".png"))) {
+        auto highDpiPath = path;
+        highDpiPath.insert(highDpiPath.size() - 4, QLatin1String("@2x"));
+        if (QFile::exists(highDpiPath)) {
+            path = std::move(highDpiPath);
+        }
+    }
+
+    auto reader = QImageReader(path);
+    reader.setScaledSize(
+        reader.size().scaled(deviceSize, Qt::KeepAspectRatio));
+    return reader.read().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+#endif
+}
+
+} // namespace CSD::Internal
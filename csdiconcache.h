@@ -0,0 +1,54 @@
+#pragma once
+
+#include "captionbuttonstyle.h"
+#include "csdcaptionicons.h"
+#include "csdtitlebarbutton.h"
+
+#include <QHash>
+#include <QImage>
+
+namespace CSD::Internal {
+
+// Process-wide store of rasterized caption button icons, shared by every
+// TitleBar. Entries are taken from the pre-rasterized CaptionAssetBundle when
+// it has the requested scale and rendered from the resources otherwise, once
+// per style, role, state and device pixel ratio. Tinted glyphs are kept as
+// alpha masks and colorized once per tint. A lookup that hits only bumps the
+// image's reference count. Images are in device pixels and carry no device
+// pixel ratio of their own, so bundle-backed entries never detach.
+class CaptionIconCache {
+public:
+    static CaptionIconCache &instance();
+
+    QImage image(CaptionButtonStyle style,
+                 TitleBarButton::Role role,
+                 CaptionButtonStates states,
+                 qreal devicePixelRatio,
+                 QRgb tint);
+    void clear();
+
+    quint64 hits() const;
+    quint64 misses() const;
+
+private:
+    CaptionIconCache() = default;
+
+    static QImage render(CaptionButtonStyle style,
+                         TitleBarButton::Role role,
+                         CaptionButtonStates states,
+                         qreal devicePixelRatio);
+
+    QImage mask(quint32 assetKey,
+                CaptionButtonStyle style,
+                TitleBarButton::Role role,
+                CaptionButtonStates states,
+                qreal devicePixelRatio);
+
+    // Keyed by the asset key in the low and the tint in the high 32 bits.
+    QHash<quint64, QImage> m_images;
+    QHash<quint32, QImage> m_masks;
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+};
+
+} // namespace CSD::Internal
@@ -0,0 +1,727 @@
+#include "csdpaintedtitlebar.h"
+
+#include "csdhittest.h"
+
+#ifdef _WIN32
+#include "qregistrywatcher.h"
+#include "qtwinbackports.h"
+#include "win32csd.h"
+
+#include <Windows.h>
+#endif
+
+#include <QApplication>
+#include <QEvent>
+#include <QMainWindow>
+#include <QMenuBar>
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <QResizeEvent>
+#include <QStyle>
+#include <QStyleOption>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include "csdsystemmove.h"
+
+#include <QDockWidget>
+#endif
+
+namespace CSD {
+
+constexpr static int kTitleBarHeight = 30;
+constexpr static int kLeftMarginWidth = 5;
+constexpr static int kCaptionIconPartWidth = 30;
+
+static bool isCaptionButtonPart(int part) {
+    return part >= TitleBarButton::Minimize && part <= TitleBarButton::Close;
+}
+
+PaintedTitleBar::PaintedTitleBar(CaptionButtonStyle captionButtonStyle,
+                                 const QIcon &captionIcon,
+                                 QWidget *parent)
+    : QWidget(parent), m_captionButtonStyle(captionButtonStyle) {
+    this->setObjectName("TitleBar");
+    this->setMinimumSize(QSize(0, kTitleBarHeight));
+    this->setMaximumSize(QSize(QWIDGETSIZE_MAX, kTitleBarHeight));
+    this->setMouseTracking(true);
+    this->setAttribute(Qt::WA_StaticContents);
+#ifdef _WIN32
+    auto maybeColor = Internal::readDWMColorizationColor();
+    if (maybeColor.has_value()) {
+        this->m_activeColor = *maybeColor;
+    }
+    auto maybeWatcher = QRegistryWatcher::create(
+        HKEY_CURRENT_USER, L"SOFTWARE\\Microsoft\\Windows\\DWM", this);
+    if (maybeWatcher.has_value()) {
+        this->m_watcher = *maybeWatcher;
+        connect(
+            this->m_watcher,
+            &QRegistryWatcher::valueChanged,
+            this,
+            [this]() {
+                auto maybeColor = Internal::readDWMColorizationColor();
+                if (!maybeColor.has_value() ||
+                    this->m_activeColorOverridden ||
+                    *maybeColor == this->m_activeColor) {
+                    return;
+                }
+                this->m_activeColor = *maybeColor;
+                if (this->m_active) {
+                    this->repaintBackground();
+                }
+            },
+            Qt::QueuedConnection);
+    }
+#endif
+
+#ifdef _WIN32
+    int icon_size = ::GetSystemMetrics(SM_CXSMICON);
+#else
+    int icon_size = 16;
+#endif
+    this->m_captionIconSize = QSize(icon_size, icon_size);
+    this->m_captionIcon = [&captionIcon, this]() -> QIcon {
+        if (!captionIcon.isNull()) {
+            return captionIcon;
+        }
+        auto globalWindowIcon = this->window()->windowIcon();
+        if (!globalWindowIcon.isNull()) {
+            return globalWindowIcon;
+        }
+        globalWindowIcon = QApplication::windowIcon();
+        if (!globalWindowIcon.isNull()) {
+            return globalWindowIcon;
+        }
+#ifdef _WIN32
+        // Use system default application icon which doesn't need margin
+        this->m_hasLeftMargin = false;
+        HICON winIcon = ::LoadIconW(nullptr, IDI_APPLICATION);
+        globalWindowIcon.addPixmap(
+            QtWinBackports::qt_pixmapFromWinHICON(winIcon));
+#else
+#if !defined(__APPLE__)
+        if (globalWindowIcon.isNull()) {
+            globalWindowIcon = QIcon::fromTheme("application-x-executable");
+        }
+#endif
+#endif
+        return globalWindowIcon;
+    }();
+
+    // Only the title bar of the main window itself takes its menu bar, not
+    // that of a dock docked in it.
+    auto *mainWindow = this->parentWidget() == this->window()
+                           ? qobject_cast<QMainWindow *>(this->window())
+                           : nullptr;
+    if (mainWindow != nullptr) {
+        this->m_menuBar = mainWindow->menuBar();
+        this->m_menuBar->setParent(this);
+        this->m_menuBar->setFixedHeight(kTitleBarHeight);
+        this->m_menuBar->show();
+    }
+
+    this->updateBackgroundMode();
+    this->setActive(this->window()->isActiveWindow());
+    this->setMaximized(static_cast<bool>(this->window()->windowState() &
+                                         Qt::WindowMaximized));
+    this->layoutParts();
+}
+
+PaintedTitleBar::~PaintedTitleBar() {
+    Internal::HoverFadeDriver::instance().cancel(this);
+    auto *mainWindow = qobject_cast<QMainWindow *>(this->parentWidget());
+    if (mainWindow != nullptr && this->m_menuBar != nullptr) {
+        mainWindow->setMenuBar(this->m_menuBar);
+    }
+    this->m_menuBar = nullptr;
+}
+
+QSize PaintedTitleBar::sizeHint() const {
+    auto width = kCaptionIconPartWidth +
+                 (this->m_hasLeftMargin ? kLeftMarginWidth : 0);
+    if (this->m_menuBar != nullptr) {
+        width += this->m_menuBar->sizeHint().width();
+    }
+    const auto buttonWidth =
+        Internal::captionStyleInfo(this->m_captionButtonStyle).buttonWidth;
+    for (int part = TitleBarButton::Minimize; part < kPartCount; ++part) {
+        if (this->m_partVisible[static_cast<std::size_t>(part)]) {
+            width += buttonWidth;
+        }
+    }
+    return QSize(width, kTitleBarHeight);
+}
+
+void PaintedTitleBar::layoutParts() {
+    const auto height = this->height();
+    const auto buttonWidth =
+        Internal::captionStyleInfo(this->m_captionButtonStyle).buttonWidth;
+    auto rects = std::array<QRect, kPartCount>();
+
+    auto left = this->m_hasLeftMargin ? kLeftMarginWidth : 0;
+    rects[std::size_t{TitleBarButton::CaptionIcon}] =
+        QRect(left, 0, kCaptionIconPartWidth, height);
+    left += kCaptionIconPartWidth;
+
+    auto right = this->width();
+    for (int part = TitleBarButton::Close; part >= TitleBarButton::Minimize;
+         --part) {
+        if (!this->m_partVisible[static_cast<std::size_t>(part)]) {
+            continue;
+        }
+        right -= buttonWidth;
+        rects[static_cast<std::size_t>(part)] =
+            QRect(right, 0, buttonWidth, height);
+    }
+
+    const auto contentsRect = this->rect();
+    for (auto &rect : rects) {
+        rect = QStyle::visualRect(this->layoutDirection(), contentsRect, rect);
+    }
+    this->m_partRects = rects;
+
+    if (this->m_menuBar != nullptr) {
+        const auto menuWidth =
+            qMax(0, qMin(this->m_menuBar->sizeHint().width(), right - left));
+        this->m_menuBar->setGeometry(
+            QStyle::visualRect(this->layoutDirection(),
+                               contentsRect,
+                               QRect(left, 0, menuWidth, height)));
+    }
+    this->updateHitTestMap();
+}
+
+int PaintedTitleBar::partAt(const QPoint &pos) const {
+    for (int part = 0; part < kPartCount; ++part) {
+        const auto index = static_cast<std::size_t>(part);
+        if (this->m_partVisible[index] &&
+            this->m_partRects[index].contains(pos)) {
+            return part;
+        }
+    }
+    return kNoPart;
+}
+
+void PaintedTitleBar::setHitTestMap(Internal::HitTestMap *map) {
+    this->m_hitTestMap = map;
+    this->updateHitTestMap();
+}
+
+void PaintedTitleBar::updateHitTestMap() {
+    if (this->m_hitTestMap == nullptr) {
+        return;
+    }
+    // The platform filter asks the map where the pointer is, so the title
+    // bar never has to look up the cursor itself.
+    const auto offset = this->mapTo(this->window(), QPoint());
+    const auto inWindow = [&offset](const QRect &rect) {
+        return rect.isNull() ? QRect() : rect.translated(offset);
+    };
+    const auto iconIndex = std::size_t{TitleBarButton::CaptionIcon};
+    this->m_hitTestMap->setCaption(
+        inWindow(this->rect()),
+        {inWindow(this->m_partRects[iconIndex]),
+         this->m_menuBar != nullptr ? inWindow(this->m_menuBar->geometry())
+                                    : QRect(),
+         inWindow(this->captionClusterRect()),
+         QRect()});
+}
+
+Internal::CaptionButtonVisual PaintedTitleBar::visualFor(int part) const {
+    const auto role = static_cast<TitleBarButton::Role>(part);
+    auto visual = Internal::CaptionButtonVisual();
+    visual.style = this->m_captionButtonStyle;
+    visual.enabled = this->isEnabled();
+    visual.background = Internal::captionButtonBackground(
+        visual.style,
+        role,
+        visual.enabled,
+        this->m_hoverColor,
+        this->m_faders[static_cast<std::size_t>(part)],
+        false);
+    if (role == TitleBarButton::CaptionIcon) {
+        return visual;
+    }
+
+    // On mac style, all caption buttons get the 'hovered' style if any of them
+    // is hovered - this mimics real macOS
+    const bool isHovered =
+        this->m_hoveredPart == part ||
+        (visual.style == CaptionButtonStyle::mac &&
+         this->isCaptionButtonHovered());
+
+    visual.states.setFlag(Internal::CaptionButtonActive, this->m_active);
+    visual.states.setFlag(Internal::CaptionButtonMaximized,
+                          this->m_maximized);
+    visual.states.setFlag(Internal::CaptionButtonHovered, isHovered);
+    visual.states.setFlag(Internal::CaptionButtonPressed,
+                          isHovered && this->m_pressedPart == part);
+
+    const auto tone =
+        Internal::captionIcon(
+            visual.style, static_cast<std::size_t>(part) - 1, visual.states)
+            .tone;
+    visual.tint = this->captionGlyphColor(tone).rgba();
+    return visual;
+}
+
+void PaintedTitleBar::updatePart(int part) {
+    const auto index = static_cast<std::size_t>(part);
+    if (!this->m_partVisible[index] ||
+        (this->m_paintedVisuals[index].has_value() &&
+         *this->m_paintedVisuals[index] == this->visualFor(part))) {
+        return;
+    }
+    if (!this->isVisibleOnScreen()) {
+        this->m_repaintPending = true;
+        return;
+    }
+    this->update(this->m_partRects[index]);
+}
+
+void PaintedTitleBar::setHoveredPart(int part) {
+    if (part == this->m_hoveredPart) {
+        return;
+    }
+    const auto previous = this->m_hoveredPart;
+    this->m_hoveredPart = part;
+    if (this->m_pressedPart == kNoPart) {
+        if (isCaptionButtonPart(previous)) {
+            this->fadePart(previous, 0.0);
+        }
+        if (isCaptionButtonPart(part)) {
+            this->fadePart(part, 1.0);
+        }
+    }
+    this->triggerCaptionRepaint();
+}
+
+void PaintedTitleBar::fadePart(int part, double target) {
+    if (this->isVisibleOnScreen()) {
+        Internal::HoverFadeDriver::instance().fadeTo(this, part, target);
+    } else {
+        this->setFadeValue(part, target);
+    }
+}
+
+double PaintedTitleBar::fadeValue(int slot) const {
+    return this->m_faders[static_cast<std::size_t>(slot)];
+}
+
+void PaintedTitleBar::setFadeValue(int slot, double value) {
+    this->m_faders[static_cast<std::size_t>(slot)] = value;
+    this->updatePart(slot);
+}
+
+bool PaintedTitleBar::event(QEvent *event) {
+    // The menu bar asks its parent for a new layout when its menus change.
+    if (event->type() == QEvent::LayoutRequest) {
+        this->layoutParts();
+    } else if (event->type() == QEvent::Polish ||
+               event->type() == QEvent::StyleChange) {
+        this->updateBackgroundMode();
+    }
+    return QWidget::event(event);
+}
+
+void PaintedTitleBar::updateBackgroundMode() {
+    // Without a style sheet PE_Widget draws nothing, so the background fill
+    // covers every pixel of the paint event.
+    this->setAttribute(Qt::WA_OpaquePaintEvent,
+                       !this->testAttribute(Qt::WA_StyleSheetTarget));
+}
+
+void PaintedTitleBar::changeEvent(QEvent *event) {
+    if (event->type() == QEvent::LayoutDirectionChange) {
+        this->layoutParts();
+    } else if (event->type() == QEvent::EnabledChange) {
+        this->update();
+    }
+    QWidget::changeEvent(event);
+}
+
+void PaintedTitleBar::leaveEvent(QEvent *event) {
+    this->setHoveredPart(kNoPart);
+    QWidget::leaveEvent(event);
+}
+
+void PaintedTitleBar::mouseMoveEvent(QMouseEvent *event) {
+    this->setHoveredPart(this->partAt(event->pos()));
+    QWidget::mouseMoveEvent(event);
+}
+
+void PaintedTitleBar::mousePressEvent(QMouseEvent *event) {
+    const auto part = this->partAt(event->pos());
+    if (event->button() == Qt::LeftButton && isCaptionButtonPart(part)) {
+        this->m_pressedPart = part;
+        this->triggerCaptionRepaint();
+        return;
+    }
+#if !defined(_WIN32) && !defined(__APPLE__)
+    // A dock widget's title bar leaves drags to the dock, which floats and
+    // moves itself.
+    const bool dock =
+        qobject_cast<QDockWidget *>(this->parentWidget()) != nullptr;
+    if (event->button() == Qt::LeftButton && part == kNoPart && !dock &&
+        Internal::startWindowMove(this, event->pos())) {
+        return;
+    }
+#endif
+    QWidget::mousePressEvent(event);
+}
+
+void PaintedTitleBar::mouseReleaseEvent(QMouseEvent *event) {
+    if (event->button() != Qt::LeftButton || this->m_pressedPart == kNoPart) {
+        QWidget::mouseReleaseEvent(event);
+        return;
+    }
+    const auto pressedPart = this->m_pressedPart;
+    this->m_pressedPart = kNoPart;
+    const auto releasedPart = this->partAt(event->pos());
+    if (releasedPart != pressedPart) {
+        // Fades were held while the button was down.
+        this->fadePart(pressedPart, 0.0);
+        if (isCaptionButtonPart(releasedPart)) {
+            this->fadePart(releasedPart, 1.0);
+        }
+    }
+    this->triggerCaptionRepaint();
+    if (releasedPart != pressedPart) {
+        return;
+    }
+    switch (pressedPart) {
+    case TitleBarButton::Minimize:
+        emit this->minimizeClicked();
+        break;
+    case TitleBarButton::MaximizeRestore:
+        emit this->maximizeRestoreClicked();
+        break;
+    case TitleBarButton::Close:
+        emit this->closeClicked();
+        break;
+    default:
+        break;
+    }
+}
+
+void PaintedTitleBar::paintEvent(QPaintEvent *event) {
+    auto painter = QPainter(this);
+    painter.fillRect(event->rect(), this->backgroundColor());
+    if (this->testAttribute(Qt::WA_StyleSheetTarget)) {
+        auto styleOption = QStyleOption();
+        styleOption.init(this);
+        this->style()->drawPrimitive(
+            QStyle::PE_Widget, &styleOption, &painter, this);
+    }
+
+    for (int part = 0; part < kPartCount; ++part) {
+        const auto index = static_cast<std::size_t>(part);
+        const auto &rect = this->m_partRects[index];
+        if (!this->m_partVisible[index] || !event->rect().intersects(rect)) {
+            continue;
+        }
+        const auto visual = this->visualFor(part);
+        this->m_paintedVisuals[index] = visual;
+        Internal::paintCaptionButton(painter,
+                                     rect,
+                                     static_cast<TitleBarButton::Role>(part),
+                                     visual,
+                                     this);
+        if (part == TitleBarButton::CaptionIcon) {
+            const auto iconRect = QStyle::alignedRect(
+                this->layoutDirection(),
+                Qt::AlignCenter,
+                this->m_captionIconSize,
+                rect);
+            this->m_captionIcon.paint(&painter,
+                                      iconRect,
+                                      Qt::AlignCenter,
+                                      this->isEnabled() ? QIcon::Normal
+                                                        : QIcon::Disabled);
+        }
+    }
+}
+
+void PaintedTitleBar::resizeEvent(QResizeEvent *event) {
+    const auto oldClusterRect = this->captionClusterRect();
+    this->layoutParts();
+    QWidget::resizeEvent(event);
+
+    // With static contents Qt only repaints what a resize exposes. A width
+    // change moves the caption buttons, so scroll their pixels along; that
+    // repaints only the background they uncover.
+    const auto oldSize = event->oldSize();
+    const bool widthOnly = oldSize.isValid() &&
+                           oldSize.height() == event->size().height();
+    if (!widthOnly || this->isRightToLeft() ||
+        !this->testAttribute(Qt::WA_OpaquePaintEvent)) {
+        this->update();
+        return;
+    }
+    const auto clusterRect = this->captionClusterRect();
+    this->scroll(clusterRect.x() - oldClusterRect.x(),
+                 0,
+                 oldClusterRect.united(clusterRect));
+}
+
+void PaintedTitleBar::moveEvent(QMoveEvent *event) {
+    QWidget::moveEvent(event);
+    this->updateHitTestMap();
+}
+
+QRect PaintedTitleBar::captionClusterRect() const {
+    auto rect = QRect();
+    for (int part = TitleBarButton::Minimize; part < kPartCount; ++part) {
+        const auto index = static_cast<std::size_t>(part);
+        if (this->m_partVisible[index]) {
+            rect = rect.united(this->m_partRects[index]);
+        }
+    }
+    return rect;
+}
+
+bool PaintedTitleBar::isActive() const {
+    return this->m_active;
+}
+
+void PaintedTitleBar::setActive(bool active) {
+    if (this->m_active == active) {
+        return;
+    }
+    this->m_active = active;
+    this->repaintBackground();
+}
+
+QColor PaintedTitleBar::backgroundColor() const {
+    return this->m_active ? this->m_activeColor : this->m_inactiveColor;
+}
+
+void PaintedTitleBar::repaintBackground() {
+    if (this->m_updateDepth > 0) {
+        this->m_pendingChanges |= BackgroundChanged;
+        return;
+    }
+    if (!this->isVisibleOnScreen()) {
+        this->m_repaintPending = true;
+        return;
+    }
+    this->syncMenuBarColor();
+    this->update();
+}
+
+void PaintedTitleBar::syncMenuBarColor() {
+    // QMenuBar paints its background from its own palette. It is the only
+    // widget that gets one, and only when the color actually changes.
+    if (this->m_menuBar == nullptr) {
+        return;
+    }
+    const auto color = this->backgroundColor();
+    auto palette = this->m_menuBar->palette();
+    if (palette.color(QPalette::Window) == color) {
+        return;
+    }
+    palette.setColor(QPalette::Window, color);
+    this->m_menuBar->setPalette(palette);
+}
+
+bool PaintedTitleBar::isMaximized() const {
+    return this->m_maximized;
+}
+
+void PaintedTitleBar::setMaximized(bool maximized) {
+    if (this->m_maximized == maximized) {
+        return;
+    }
+    this->m_maximized = maximized;
+    this->triggerCaptionRepaint();
+}
+
+void PaintedTitleBar::setMinimizable(bool on) {
+    auto &visible = this->m_partVisible[std::size_t{TitleBarButton::Minimize}];
+    if (visible == on) {
+        return;
+    }
+    visible = on;
+    this->layoutParts();
+    this->updateGeometry();
+    this->update();
+}
+
+void PaintedTitleBar::setMaximizable(bool on) {
+    auto &visible =
+        this->m_partVisible[std::size_t{TitleBarButton::MaximizeRestore}];
+    if (visible == on) {
+        return;
+    }
+    visible = on;
+    this->layoutParts();
+    this->updateGeometry();
+    this->update();
+}
+
+QColor PaintedTitleBar::activeColor() {
+    return this->m_activeColor;
+}
+
+void PaintedTitleBar::setActiveColor(const QColor &activeColor) {
+#ifdef _WIN32
+    this->m_activeColorOverridden = true;
+#endif
+    if (this->m_activeColor == activeColor) {
+        return;
+    }
+    this->m_activeColor = activeColor;
+    if (this->m_active) {
+        this->repaintBackground();
+    }
+}
+
+QColor PaintedTitleBar::inactiveColor() {
+    return this->m_inactiveColor;
+}
+
+void PaintedTitleBar::setInactiveColor(const QColor &inactiveColor) {
+    if (this->m_inactiveColor == inactiveColor) {
+        return;
+    }
+    this->m_inactiveColor = inactiveColor;
+    if (!this->m_active) {
+        this->repaintBackground();
+    }
+}
+
+QColor PaintedTitleBar::hoverColor() const {
+    return this->m_hoverColor;
+}
+
+void PaintedTitleBar::setHoverColor(QColor hoverColor) {
+    if (this->m_hoverColor == hoverColor) {
+        return;
+    }
+    this->m_hoverColor = std::move(hoverColor);
+    this->triggerCaptionRepaint();
+}
+
+QColor PaintedTitleBar::foregroundColor() const {
+    return this->m_foregroundColor;
+}
+
+void PaintedTitleBar::setForegroundColor(QColor foregroundColor) {
+    if (this->m_foregroundColor == foregroundColor) {
+        return;
+    }
+    this->m_foregroundColor = std::move(foregroundColor);
+    this->triggerCaptionRepaint();
+}
+
+QColor PaintedTitleBar::inactiveForegroundColor() const {
+    return this->m_inactiveForegroundColor;
+}
+
+void PaintedTitleBar::setInactiveForegroundColor(
+    QColor inactiveForegroundColor) {
+    if (this->m_inactiveForegroundColor == inactiveForegroundColor) {
+        return;
+    }
+    this->m_inactiveForegroundColor = std::move(inactiveForegroundColor);
+    this->triggerCaptionRepaint();
+}
+
+QColor
+PaintedTitleBar::captionGlyphColor(Internal::CaptionGlyphTone tone) const {
+    switch (tone) {
+    case Internal::CaptionGlyphTone::Normal:
+        return this->m_foregroundColor;
+    case Internal::CaptionGlyphTone::Inactive:
+        return this->m_inactiveForegroundColor;
+    case Internal::CaptionGlyphTone::Highlight:
+        return Qt::white;
+    case Internal::CaptionGlyphTone::None:
+        break;
+    }
+    return QColor();
+}
+
+CaptionButtonStyle PaintedTitleBar::captionButtonStyle() const {
+    return this->m_captionButtonStyle;
+}
+
+void PaintedTitleBar::setCaptionButtonStyle(
+    CaptionButtonStyle captionButtonStyle) {
+    this->m_captionButtonStyle = captionButtonStyle;
+    this->layoutParts();
+    this->updateGeometry();
+    this->update();
+}
+
+void PaintedTitleBar::onWindowStateChange(Qt::WindowStates state) {
+    this->beginUpdate();
+    const bool wasVisible = this->isVisibleOnScreen();
+    this->m_minimized = static_cast<bool>(state & Qt::WindowMinimized);
+    this->onScreenVisibilityChanged(wasVisible);
+    this->setMaximized(static_cast<bool>(state & Qt::WindowMaximized));
+    this->commitUpdate();
+}
+
+void PaintedTitleBar::beginUpdate() {
+    ++this->m_updateDepth;
+}
+
+void PaintedTitleBar::commitUpdate() {
+    Q_ASSERT(this->m_updateDepth > 0);
+    if (--this->m_updateDepth > 0) {
+        return;
+    }
+    const auto changes = this->m_pendingChanges;
+    this->m_pendingChanges = 0;
+    // A background repaint covers the caption buttons as well.
+    if (changes & BackgroundChanged) {
+        this->repaintBackground();
+    } else if (changes & CaptionChanged) {
+        this->triggerCaptionRepaint();
+    }
+}
+
+bool PaintedTitleBar::isVisibleOnScreen() const {
+    return this->m_visibleOnScreen && !this->m_minimized;
+}
+
+void PaintedTitleBar::setVisibleOnScreen(bool visible) {
+    const bool wasVisible = this->isVisibleOnScreen();
+    this->m_visibleOnScreen = visible;
+    this->onScreenVisibilityChanged(wasVisible);
+}
+
+void PaintedTitleBar::onScreenVisibilityChanged(bool wasVisible) {
+    const bool visible = this->isVisibleOnScreen();
+    if (visible == wasVisible) {
+        return;
+    }
+    if (!visible) {
+        // Nobody sees the fades, jump to where they would end.
+        Internal::HoverFadeDriver::instance().settle(this);
+        return;
+    }
+    if (this->m_repaintPending) {
+        this->m_repaintPending = false;
+        this->syncMenuBarColor();
+        this->update();
+    }
+}
+
+bool PaintedTitleBar::isCaptionButtonHovered() const {
+    return isCaptionButtonPart(this->m_hoveredPart);
+}
+
+void PaintedTitleBar::triggerCaptionRepaint() {
+    if (this->m_updateDepth > 0) {
+        this->m_pendingChanges |= CaptionChanged;
+        return;
+    }
+    for (int part = TitleBarButton::Minimize; part < kPartCount; ++part) {
+        this->updatePart(part);
+    }
+}
+
+} // namespace CSD
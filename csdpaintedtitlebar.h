@@ -0,0 +1,153 @@
+#pragma once
+
+#include "captionbuttonstyle.h"
+#include "csdcaptionicons.h"
+#include "csdfadedriver.h"
+#include "csdtitlebarbutton.h"
+#include "csdtitlebarclient.h"
+
+#include <QColor>
+#include <QIcon>
+#include <QWidget>
+
+#include <array>
+#include <optional>
+
+class QMenuBar;
+
+#ifdef _WIN32
+class QRegistryWatcher;
+#endif
+
+namespace CSD {
+
+// Drop-in alternative to TitleBar that is a single widget. It lays out, hit
+// tests and paints the caption icon and the caption buttons itself instead of
+// using a layout and a QPushButton per button. Only the menu bar of a
+// QMainWindow remains a child widget. DecorationManager picks it with
+// TitleBarKind::painted.
+class PaintedTitleBar : public QWidget,
+                        public Internal::FadeClient,
+                        public Internal::TitleBarClient {
+    Q_OBJECT
+    Q_PROPERTY(bool active READ isActive WRITE setActive)
+    Q_PROPERTY(bool maximized READ isMaximized WRITE setMaximized)
+
+private:
+    // Parts are indexed by TitleBarButton::Role.
+    static constexpr int kPartCount = 4;
+    static constexpr int kNoPart = -1;
+
+#ifdef _WIN32
+    bool m_activeColorOverridden = false;
+    QRegistryWatcher *m_watcher = nullptr;
+#endif
+    bool m_active = false;
+    bool m_maximized = false;
+    bool m_minimized = false;
+    bool m_visibleOnScreen = true;
+    bool m_repaintPending = false;
+    // Changes held back by an open beginUpdate().
+    enum PendingChange {
+        BackgroundChanged = 0x1,
+        CaptionChanged = 0x2,
+    };
+    int m_updateDepth = 0;
+    int m_pendingChanges = 0;
+    bool m_hasLeftMargin = true;
+    QColor m_activeColor = Qt::black;
+    QColor m_inactiveColor = Qt::white;
+    QColor m_hoverColor = Qt::gray;
+    QColor m_foregroundColor = QColor(0xAB, 0xB2, 0xBF);
+    QColor m_inactiveForegroundColor = QColor(0x5C, 0x63, 0x70);
+    CaptionButtonStyle m_captionButtonStyle;
+    QIcon m_captionIcon;
+    QSize m_captionIconSize;
+    QMenuBar *m_menuBar = nullptr;
+    Internal::HitTestMap *m_hitTestMap = nullptr;
+    int m_hoveredPart = kNoPart;
+    int m_pressedPart = kNoPart;
+    std::array<bool, kPartCount> m_partVisible = {true, true, true, true};
+    std::array<QRect, kPartCount> m_partRects;
+    std::array<double, kPartCount> m_faders = {};
+    std::array<std::optional<Internal::CaptionButtonVisual>, kPartCount>
+        m_paintedVisuals;
+
+    void layoutParts();
+    QRect captionClusterRect() const;
+    int partAt(const QPoint &pos) const;
+    Internal::CaptionButtonVisual visualFor(int part) const;
+    void updatePart(int part);
+    void setHoveredPart(int part);
+    void fadePart(int part, double target);
+    void repaintBackground();
+    void syncMenuBarColor();
+    void onScreenVisibilityChanged(bool wasVisible);
+    void updateBackgroundMode();
+    void updateHitTestMap();
+
+    double fadeValue(int slot) const override;
+    void setFadeValue(int slot, double value) override;
+
+protected:
+    bool event(QEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    void leaveEvent(QEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void moveEvent(QMoveEvent *event) override;
+
+public:
+    explicit PaintedTitleBar(CaptionButtonStyle captionButtonStyle,
+                             const QIcon &captionIcon = QIcon(),
+                             QWidget *parent = nullptr);
+    ~PaintedTitleBar() override;
+
+    QSize sizeHint() const override;
+
+    bool isActive() const;
+    void setActive(bool active) override;
+    bool isMaximized() const;
+    void setMaximized(bool maximized);
+    void setMinimizable(bool on);
+    void setMaximizable(bool on);
+    QColor activeColor();
+    void setActiveColor(const QColor &activeColor);
+    QColor inactiveColor();
+    void setInactiveColor(const QColor &inactiveColor);
+    // The color the background is painted with, depending on isActive().
+    QColor backgroundColor() const;
+    QColor hoverColor() const;
+    void setHoverColor(QColor hoverColor);
+    QColor foregroundColor() const;
+    void setForegroundColor(QColor foregroundColor);
+    QColor inactiveForegroundColor() const;
+    void setInactiveForegroundColor(QColor inactiveForegroundColor);
+    QColor captionGlyphColor(Internal::CaptionGlyphTone tone) const;
+    CaptionButtonStyle captionButtonStyle() const;
+    void setCaptionButtonStyle(CaptionButtonStyle captionButtonStyle);
+    void onWindowStateChange(Qt::WindowStates state) override;
+    // Between beginUpdate() and the matching commitUpdate(), state and color
+    // setters only record what changed. The outermost commitUpdate() then
+    // schedules a single repaint for all of it. Calls nest.
+    void beginUpdate();
+    void commitUpdate();
+    // The caption is the title bar less its parts and the menu bar.
+    void setHitTestMap(Internal::HitTestMap *map) override;
+
+    bool isVisibleOnScreen() const;
+    void setVisibleOnScreen(bool visible) override;
+
+    bool isCaptionButtonHovered() const;
+    void triggerCaptionRepaint();
+
+signals:
+    void minimizeClicked();
+    void maximizeRestoreClicked();
+    void closeClicked();
+};
+
+} // namespace CSD
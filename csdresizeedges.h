@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QCursor>
+#include <QPoint>
+#include <QSize>
+
+#include <array>
+#include <cstddef>
+
+namespace CSD::Internal {
+
+constexpr int kResizeBorderWidth = 8;
+
+// The window edges a resize started at pos would move, pos being inside a
+// window of size size and relative to its top left corner. A corner yields
+// both of its edges. Empty where pos is not on the border or the window cannot
+// be resized in that direction.
+inline Qt::Edges resizeEdgesAt(const QPoint &pos,
+                               const QSize &size,
+                               bool resizeWidth,
+                               bool resizeHeight,
+                               int borderWidth = kResizeBorderWidth) {
+    auto horizontal = Qt::Edges();
+    if (resizeWidth) {
+        if (pos.x() < borderWidth) {
+            horizontal = Qt::LeftEdge;
+        }
+        if (pos.x() >= size.width() - borderWidth) {
+            horizontal = Qt::RightEdge;
+        }
+    }
+    auto vertical = Qt::Edges();
+    if (resizeHeight) {
+        if (pos.y() >= size.height() - borderWidth) {
+            vertical = Qt::BottomEdge;
+        }
+        if (pos.y() < borderWidth) {
+            vertical = Qt::TopEdge;
+        }
+    }
+    return horizontal | vertical;
+}
+
+// The resize cursor for every combination of edges, built once and indexed
+// by the Qt::Edges value.
+inline const QCursor &resizeCursor(Qt::Edges edges) {
+    static const auto cursors = [] {
+        auto table = std::array<QCursor, 16>();
+        const auto set = [&table](Qt::Edges edges, Qt::CursorShape shape) {
+            table[static_cast<std::size_t>(edges)] = QCursor(shape);
+        };
+        set(Qt::LeftEdge, Qt::SizeHorCursor);
+        set(Qt::RightEdge, Qt::SizeHorCursor);
+        set(Qt::TopEdge, Qt::SizeVerCursor);
+        set(Qt::BottomEdge, Qt::SizeVerCursor);
+        set(Qt::TopEdge | Qt::LeftEdge, Qt::SizeFDiagCursor);
+        set(Qt::BottomEdge | Qt::RightEdge, Qt::SizeFDiagCursor);
+        set(Qt::TopEdge | Qt::RightEdge, Qt::SizeBDiagCursor);
+        set(Qt::BottomEdge | Qt::LeftEdge, Qt::SizeBDiagCursor);
+        return table;
+    }();
+    return cursors[static_cast<std::size_t>(edges)];
+}
+
+} // namespace CSD::Internal
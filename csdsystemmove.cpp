@@ -0,0 +1,97 @@
+#include "csdsystemmove.h"
+
+#include <QElapsedTimer>
+#include <QWidget>
+#include <QWindow>
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include "linuxcsd.h"
+
+#include <QX11Info>
+#endif
+
+#include <array>
+#include <cstddef>
+
+namespace CSD::Internal {
+
+// Indexed by MoveResizeBackend.
+static std::array<DragStartLatency, 3> s_dragStartLatency;
+
+static MoveResizeBackend detectMoveResizeBackend() {
+#if !defined(_WIN32) && !defined(__APPLE__)
+    if (QX11Info::isPlatformX11()) {
+        return MoveResizeBackend::Xcb;
+    }
+#endif
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    return MoveResizeBackend::QWindow;
+#else
+    return MoveResizeBackend::None;
+#endif
+}
+
+MoveResizeBackend moveResizeBackend() {
+    static const auto backend = detectMoveResizeBackend();
+    return backend;
+}
+
+static void recordLatency(MoveResizeBackend backend,
+                          const QElapsedTimer &timer) {
+    auto &latency = s_dragStartLatency[static_cast<std::size_t>(backend)];
+    const auto elapsed = timer.nsecsElapsed();
+    ++latency.count;
+    latency.totalNanoseconds += elapsed;
+    latency.maxNanoseconds = qMax(latency.maxNanoseconds, elapsed);
+}
+
+// An empty edges starts a move.
+static bool startMoveResize([[maybe_unused]] QWidget *widget,
+                            [[maybe_unused]] const QPoint &pos,
+                            Qt::Edges edges) {
+    auto timer = QElapsedTimer();
+    timer.start();
+    const auto backend = moveResizeBackend();
+    bool started = false;
+    switch (backend) {
+    case MoveResizeBackend::None:
+        return false;
+    case MoveResizeBackend::Xcb:
+#if !defined(_WIN32) && !defined(__APPLE__)
+        started = !edges ? startSystemMove(widget, pos)
+                         : startSystemResize(widget, pos, edges);
+#endif
+        break;
+    case MoveResizeBackend::QWindow: {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+        auto *window = widget->window()->windowHandle();
+        if (window != nullptr) {
+            started = !edges ? window->startSystemMove()
+                             : window->startSystemResize(edges);
+        }
+#endif
+        break;
+    }
+    }
+    if (started) {
+        recordLatency(backend, timer);
+    }
+    return started;
+}
+
+bool startWindowMove(QWidget *widget, const QPoint &pos) {
+    return startMoveResize(widget, pos, Qt::Edges());
+}
+
+bool startWindowResize(QWidget *widget, const QPoint &pos, Qt::Edges edges) {
+    if (!edges) {
+        return false;
+    }
+    return startMoveResize(widget, pos, edges);
+}
+
+DragStartLatency dragStartLatency(MoveResizeBackend backend) {
+    return s_dragStartLatency[static_cast<std::size_t>(backend)];
+}
+
+} // namespace CSD::Internal
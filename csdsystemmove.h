@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QtGlobal>
+
+class QPoint;
+class QWidget;
+
+namespace CSD::Internal {
+
+// How the decorations hand window moves and resizes to the windowing system.
+// Chosen once per process from the platform plugin.
+enum class MoveResizeBackend {
+    None,
+    // _NET_WM_MOVERESIZE, with a client driven fallback; see linuxcsd.h.
+    Xcb,
+    // QWindow::startSystemMove() and startSystemResize(), Qt 5.15 and up.
+    QWindow,
+};
+
+MoveResizeBackend moveResizeBackend();
+
+// Start a move or resize of the window of widget as if dragged from pos,
+// given in widget coordinates. Return false if the backend cannot, in which
+// case the press should be handled as usual.
+bool startWindowMove(QWidget *widget, const QPoint &pos);
+bool startWindowResize(QWidget *widget, const QPoint &pos, Qt::Edges edges);
+
+// Time spent handing a move or resize over to the backend, from entering
+// startWindowMove() or startWindowResize() until the request is sent.
+struct DragStartLatency {
+    quint64 count = 0;
+    qint64 totalNanoseconds = 0;
+    qint64 maxNanoseconds = 0;
+};
+
+DragStartLatency dragStartLatency(MoveResizeBackend backend);
+
+} // namespace CSD::Internal
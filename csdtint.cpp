@@ -0,0 +1,168 @@
+#include "csdtint.h"
+
+#include <private/qsimd_p.h>
+
+#include <cstring>
+
+namespace CSD::Internal {
+
+using TintRowFunction = void (*)(const uchar *, quint32 *, int, quint32);
+
+// Same rounding as Qt's BYTE_MUL, so all paths produce identical pixels.
+static inline quint32 byteMul(quint32 x, quint32 a) {
+    quint32 t = (x & 0xff00ffu) * a;
+    t = (t + ((t >> 8u) & 0xff00ffu) + 0x800080u) >> 8u;
+    t &= 0xff00ffu;
+    x = ((x >> 8u) & 0xff00ffu) * a;
+    x = x + ((x >> 8u) & 0xff00ffu) + 0x800080u;
+    x &= 0xff00ff00u;
+    return x | t;
+}
+
+static void
+tintRowScalar(const uchar *mask, quint32 *dst, int width, quint32 color) {
+    for (int x = 0; x < width; ++x) {
+        dst[x] = byteMul(color, mask[x]);
+    }
+}
+
+#ifdef __SSE2__
+static inline __m128i mul255Sse2(__m128i a, __m128i b) {
+    const __m128i product = _mm_mullo_epi16(a, b);
+    return _mm_srli_epi16(
+        _mm_add_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)),
+                      _mm_set1_epi16(0x80)),
+        8);
+}
+
+static void
+tintRowSse2(const uchar *mask, quint32 *dst, int width, quint32 color) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i color16 =
+        _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(color)), zero);
+    int x = 0;
+    for (; x + 4 <= width; x += 4) {
+        int alphas = 0;
+        std::memcpy(&alphas, mask + x, sizeof(alphas));
+        // Spread each coverage byte over the four channels of its pixel.
+        __m128i coverage = _mm_cvtsi32_si128(alphas);
+        coverage = _mm_unpacklo_epi8(coverage, coverage);
+        coverage = _mm_unpacklo_epi16(coverage, coverage);
+        const __m128i low =
+            mul255Sse2(color16, _mm_unpacklo_epi8(coverage, zero));
+        const __m128i high =
+            mul255Sse2(color16, _mm_unpackhi_epi8(coverage, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x),
+                         _mm_packus_epi16(low, high));
+    }
+    tintRowScalar(mask + x, dst + x, width - x, color);
+}
+#endif
+
+#if QT_COMPILER_SUPPORTS_HERE(AVX2)
+QT_FUNCTION_TARGET(AVX2)
+static void
+tintRowAvx2(const uchar *mask, quint32 *dst, int width, quint32 color) {
+    const __m256i half = _mm256_set1_epi16(0x80);
+    const __m256i color16 =
+        _mm256_cvtepu8_epi16(_mm_set1_epi32(static_cast<int>(color)));
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i coverage =
+            _mm_loadl_epi64(reinterpret_cast<const __m128i *>(mask + x));
+        coverage = _mm_unpacklo_epi8(coverage, coverage);
+        const __m256i lowProduct = _mm256_mullo_epi16(
+            color16,
+            _mm256_cvtepu8_epi16(_mm_unpacklo_epi16(coverage, coverage)));
+        const __m256i highProduct = _mm256_mullo_epi16(
+            color16,
+            _mm256_cvtepu8_epi16(_mm_unpackhi_epi16(coverage, coverage)));
+        const __m256i low = _mm256_srli_epi16(
+            _mm256_add_epi16(
+                _mm256_add_epi16(lowProduct,
+                                 _mm256_srli_epi16(lowProduct, 8)),
+                half),
+            8);
+        const __m256i high = _mm256_srli_epi16(
+            _mm256_add_epi16(
+                _mm256_add_epi16(highProduct,
+                                 _mm256_srli_epi16(highProduct, 8)),
+                half),
+            8);
+        // packus works per 128-bit lane, restore pixel order afterwards.
+        const __m256i packed =
+            _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xd8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), packed);
+    }
+    tintRowScalar(mask + x, dst + x, width - x, color);
+}
+#endif
+
+static TintRowFunction tintRowFunction() {
+#if QT_COMPILER_SUPPORTS_HERE(AVX2)
+    if (qCpuHasFeature(AVX2)) {
+        return tintRowAvx2;
+    }
+#endif
+#ifdef __SSE2__
+    return tintRowSse2;
+#else
+    return tintRowScalar;
+#endif
+}
+
+static TintRowFunction tintRowFunction(TintKernel kernel) {
+    switch (kernel) {
+    case TintKernel::Scalar:
+        return tintRowScalar;
+    case TintKernel::Sse2:
+#ifdef __SSE2__
+        return tintRowSse2;
+#else
+        return nullptr;
+#endif
+    case TintKernel::Avx2:
+#if QT_COMPILER_SUPPORTS_HERE(AVX2)
+        return qCpuHasFeature(AVX2) ? tintRowAvx2 : nullptr;
+#else
+        return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+static void tintRows(const QImage &mask,
+                     QRgb color,
+                     QImage &dst,
+                     TintRowFunction tintRow) {
+    Q_ASSERT(mask.format() == QImage::Format_Alpha8);
+    Q_ASSERT(dst.format() == QImage::Format_ARGB32_Premultiplied);
+    Q_ASSERT(mask.size() == dst.size());
+
+    const auto premultiplied = static_cast<quint32>(qPremultiply(color));
+    for (int y = 0; y < mask.height(); ++y) {
+        tintRow(mask.constScanLine(y),
+                reinterpret_cast<quint32 *>(dst.scanLine(y)),
+                mask.width(),
+                premultiplied);
+    }
+}
+
+void tintAlphaMask(const QImage &mask, QRgb color, QImage &dst) {
+    static const TintRowFunction tintRow = tintRowFunction();
+    tintRows(mask, color, dst, tintRow);
+}
+
+bool tintAlphaMask(const QImage &mask,
+                   QRgb color,
+                   QImage &dst,
+                   TintKernel kernel) {
+    const auto tintRow = tintRowFunction(kernel);
+    if (tintRow == nullptr) {
+        return false;
+    }
+    tintRows(mask, color, dst, tintRow);
+    return true;
+}
+
+} // namespace CSD::Internal
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <QImage>
+#include <QRgb>
+
+namespace CSD::Internal {
+
+// Writes color, premultiplied and scaled by the coverage in mask, into dst.
+// mask must be Format_Alpha8 and dst Format_ARGB32_Premultiplied of the same
+// size. Uses AVX2 or SSE2 where available and falls back to scalar code.
+void tintAlphaMask(const QImage &mask, QRgb color, QImage &dst);
+
+enum class TintKernel { Scalar, Sse2, Avx2 };
+
+// As above with a given kernel, for comparing them. Returns false and leaves
+// dst untouched when the kernel is not built in or the CPU lacks it.
+bool tintAlphaMask(const QImage &mask,
+                   QRgb color,
+                   QImage &dst,
+                   TintKernel kernel);
+
+} // namespace CSD::Internal
@@ -1,10 +1,13 @@
 #include "csdtitlebar.h"
 
+#include "csdfadedriver.h"
+#include "csdhittest.h"
 #include "csdtitlebarbutton.h"
 
 #ifdef _WIN32
 #include "qregistrywatcher.h"
 #include "qtwinbackports.h"
+#include "win32csd.h"
 
 #include <Windows.h>
 #include <dwmapi.h>
@@ -15,35 +18,45 @@
 #include <QEvent>
 #include <QMainWindow>
 #include <QMenuBar>
+#include <QPaintEvent>
 #include <QPainter>
 #include <QStyleOption>
 #include <QTimer>
 
-#if !defined(_WIN32) && !defined(__APPLE__)
-#include <QMouseEvent>
-#include <QWindow>
-
-#include <QX11Info>
+#include <utility>
 
-#include <private/qhighdpiscaling_p.h>
-#include <qpa/qplatformscreen.h>
-#include <qpa/qplatformwindow.h>
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include "csdsystemmove.h"
 
-#include <cstring>
+#include <QDockWidget>
+#include <QMouseEvent>
 #endif
 
 namespace CSD {
 
-#if !defined(_WIN32) && !defined(__APPLE__)
-constexpr static const char _NET_WM_MOVERESIZE[] = "_NET_WM_MOVERESIZE";
+namespace {
+
+// Holds the caption buttons. Being opaque lets Qt move it by scrolling its
+// pixels rather than repainting it.
+class CaptionCluster : public QWidget {
+public:
+    explicit CaptionCluster(TitleBar *titleBar)
+        : QWidget(titleBar), m_titleBar(titleBar) {}
 
-static QWidget *titleBarTopLevelWidget(QWidget *w) {
-    while (w && !w->isWindow() && w->windowType() != Qt::SubWindow) {
-        w = w->parentWidget();
+protected:
+    void paintEvent(QPaintEvent *event) override {
+        if (!this->testAttribute(Qt::WA_OpaquePaintEvent)) {
+            return;
+        }
+        auto painter = QPainter(this);
+        painter.fillRect(event->rect(), this->m_titleBar->backgroundColor());
     }
-    return w;
-}
-#endif
+
+private:
+    TitleBar *m_titleBar;
+};
+
+} // namespace
 
 TitleBar::TitleBar(CaptionButtonStyle captionButtonStyle,
                    const QIcon &captionIcon,
@@ -53,7 +66,7 @@ TitleBar::TitleBar(CaptionButtonStyle captionButtonStyle,
     this->setMinimumSize(QSize(0, 30));
     this->setMaximumSize(QSize(QWIDGETSIZE_MAX, 30));
 #ifdef _WIN32
-    auto maybeColor = this->readDWMColorizationColor();
+    auto maybeColor = Internal::readDWMColorizationColor();
     if (maybeColor.has_value()) {
         this->m_activeColor = *maybeColor;
     }
@@ -67,10 +80,15 @@ TitleBar::TitleBar(CaptionButtonStyle captionButtonStyle,
             &QRegistryWatcher::valueChanged,
             this,
             [this]() {
-                auto maybeColor = this->readDWMColorizationColor();
-                if (maybeColor.has_value() && !this->m_activeColorOverridden) {
-                    this->m_activeColor = *maybeColor;
-                    this->update();
+                auto maybeColor = Internal::readDWMColorizationColor();
+                if (!maybeColor.has_value() ||
+                    this->m_activeColorOverridden ||
+                    *maybeColor == this->m_activeColor) {
+                    return;
+                }
+                this->m_activeColor = *maybeColor;
+                if (this->m_active) {
+                    this->repaintBackground();
                 }
             },
             Qt::QueuedConnection);
@@ -133,43 +151,38 @@ TitleBar::TitleBar(CaptionButtonStyle captionButtonStyle,
     this->m_buttonCaptionIcon->setIcon(icon);
     this->m_horizontalLayout->addWidget(this->m_buttonCaptionIcon);
 
-    auto *mainWindow = qobject_cast<QMainWindow *>(this->window());
+    // Only the title bar of the main window itself takes its menu bar, not
+    // that of a dock docked in it.
+    auto *mainWindow = this->parentWidget() == this->window()
+                           ? qobject_cast<QMainWindow *>(this->window())
+                           : nullptr;
     if (mainWindow != nullptr) {
         this->m_menuBar = mainWindow->menuBar();
         this->m_horizontalLayout->addWidget(this->m_menuBar);
         this->m_menuBar->setFixedHeight(30);
     }
 
-    auto *emptySpace = new QWidget(this);
-    emptySpace->setAttribute(Qt::WA_TransparentForMouseEvents);
-    this->m_horizontalLayout->addWidget(emptySpace, 1);
+    this->m_horizontalLayout->addStretch(1);
 
-    int captionButtonsWidth = 0;
-    switch (this->m_captionButtonStyle) {
-    case CaptionButtonStyle::custom: {
-        captionButtonsWidth = 30;
-        break;
-    }
-    case CaptionButtonStyle::win: {
-        captionButtonsWidth = 46;
-        break;
-    }
-    case CaptionButtonStyle::mac: {
-        captionButtonsWidth = 26;
-        break;
-    }
-    }
+    // The caption buttons sit in an opaque container outside the layout that
+    // is kept at the trailing edge, so a width change only moves it.
+    this->m_captionCluster = new CaptionCluster(this);
+    this->m_captionCluster->setObjectName("CaptionButtons");
+
+    const auto captionButtonsSize = QSize(
+        Internal::captionStyleInfo(this->m_captionButtonStyle).buttonWidth,
+        30);
+    const auto iconSize =
+        Internal::captionIconSize(this->m_captionButtonStyle);
 
     this->m_buttonMinimize =
         new TitleBarButton(TitleBarButton::Minimize, this);
     this->m_buttonMinimize->setObjectName("ButtonMinimize");
-    this->m_buttonMinimize->setMinimumSize(QSize(captionButtonsWidth, 30));
-    this->m_buttonMinimize->setMaximumSize(QSize(captionButtonsWidth, 30));
+    this->m_buttonMinimize->setMinimumSize(captionButtonsSize);
+    this->m_buttonMinimize->setMaximumSize(captionButtonsSize);
     this->m_buttonMinimize->setFocusPolicy(Qt::NoFocus);
-    this->m_buttonMinimize->setIconSize(
-        this->m_captionButtonStyle == CaptionButtonStyle::mac ? QSize(16, 16)
-                                                              : QSize(12, 12));
-    this->m_horizontalLayout->addWidget(this->m_buttonMinimize);
+    this->m_buttonMinimize->setIconSize(iconSize);
+    this->m_buttonMinimize->setParent(this->m_captionCluster);
     connect(this->m_buttonMinimize, &QPushButton::clicked, this, [this]() {
         emit this->minimizeClicked();
     });
@@ -177,15 +190,11 @@ TitleBar::TitleBar(CaptionButtonStyle captionButtonStyle,
     this->m_buttonMaximizeRestore =
         new TitleBarButton(TitleBarButton::MaximizeRestore, this);
     this->m_buttonMaximizeRestore->setObjectName("ButtonMaximizeRestore");
-    this->m_buttonMaximizeRestore->setMinimumSize(
-        QSize(captionButtonsWidth, 30));
-    this->m_buttonMaximizeRestore->setMaximumSize(
-        QSize(captionButtonsWidth, 30));
+    this->m_buttonMaximizeRestore->setMinimumSize(captionButtonsSize);
+    this->m_buttonMaximizeRestore->setMaximumSize(captionButtonsSize);
     this->m_buttonMaximizeRestore->setFocusPolicy(Qt::NoFocus);
-    this->m_buttonMaximizeRestore->setIconSize(
-        this->m_captionButtonStyle == CaptionButtonStyle::mac ? QSize(16, 16)
-                                                              : QSize(12, 12));
-    this->m_horizontalLayout->addWidget(this->m_buttonMaximizeRestore);
+    this->m_buttonMaximizeRestore->setIconSize(iconSize);
+    this->m_buttonMaximizeRestore->setParent(this->m_captionCluster);
     connect(this->m_buttonMaximizeRestore,
             &QPushButton::clicked,
             this,
@@ -193,52 +202,26 @@ TitleBar::TitleBar(CaptionButtonStyle captionButtonStyle,
 
     this->m_buttonClose = new TitleBarButton(TitleBarButton::Close, this);
     this->m_buttonClose->setObjectName("ButtonClose");
-    this->m_buttonClose->setMinimumSize(QSize(captionButtonsWidth, 30));
-    this->m_buttonClose->setMaximumSize(QSize(captionButtonsWidth, 30));
+    this->m_buttonClose->setMinimumSize(captionButtonsSize);
+    this->m_buttonClose->setMaximumSize(captionButtonsSize);
     this->m_buttonClose->setFocusPolicy(Qt::NoFocus);
-    this->m_buttonClose->setIconSize(
-        this->m_captionButtonStyle == CaptionButtonStyle::mac ? QSize(16, 16)
-                                                              : QSize(12, 12));
-    this->m_horizontalLayout->addWidget(this->m_buttonClose);
+    this->m_buttonClose->setIconSize(iconSize);
+    this->m_buttonClose->setParent(this->m_captionCluster);
     connect(this->m_buttonClose, &QPushButton::clicked, this, [this]() {
         emit this->closeClicked();
     });
 
-    this->setAutoFillBackground(true);
+    this->setAttribute(Qt::WA_StaticContents);
+    this->layoutCaptionCluster();
+    this->updateBackgroundMode();
     this->setActive(this->window()->isActiveWindow());
     this->setMaximized(static_cast<bool>(this->window()->windowState() &
                                          Qt::WindowMaximized));
 }
 
-#ifdef _WIN32
-std::optional<QColor> TitleBar::readDWMColorizationColor() {
-    auto handleKey = ::HKEY();
-    auto regOpenResult = ::RegOpenKeyExW(HKEY_CURRENT_USER,
-                                         L"SOFTWARE\\Microsoft\\Windows\\DWM",
-                                         0,
-                                         KEY_READ,
-                                         &handleKey);
-    if (regOpenResult != ERROR_SUCCESS) {
-        return std::nullopt;
-    }
-    auto value = ::DWORD();
-    auto dwordBufferSize = ::DWORD(sizeof(::DWORD));
-    auto regQueryResult = ::RegQueryValueExW(handleKey,
-                                             L"ColorizationColor",
-                                             nullptr,
-                                             nullptr,
-                                             reinterpret_cast<LPBYTE>(&value),
-                                             &dwordBufferSize);
-    if (regQueryResult != ERROR_SUCCESS) {
-        return std::nullopt;
-    }
-    return QColor(static_cast<QRgb>(value));
-}
-#endif
-
 TitleBar::~TitleBar() {
-    auto *mainWindow = qobject_cast<QMainWindow *>(this->window());
-    if (mainWindow != nullptr) {
+    auto *mainWindow = qobject_cast<QMainWindow *>(this->parentWidget());
+    if (mainWindow != nullptr && this->m_menuBar != nullptr) {
         mainWindow->setMenuBar(this->m_menuBar);
     }
     this->m_menuBar = nullptr;
@@ -246,75 +229,127 @@ TitleBar::~TitleBar() {
 
 #if !defined(_WIN32) && !defined(__APPLE__)
 void TitleBar::mousePressEvent(QMouseEvent *event) {
-    if (!QX11Info::isPlatformX11() || event->button() != Qt::LeftButton) {
+    // A dock widget's title bar leaves drags to the dock, which floats and
+    // moves itself.
+    const bool dock =
+        qobject_cast<QDockWidget *>(this->parentWidget()) != nullptr;
+    if (event->button() != Qt::LeftButton || dock ||
+        !Internal::startWindowMove(this, event->pos())) {
         QWidget::mousePressEvent(event);
-        return;
     }
+}
+#endif
 
-    QWidget *tlw = titleBarTopLevelWidget(this);
-
-    if (tlw->isWindow() && tlw->windowHandle() &&
-        !(tlw->windowFlags() & Qt::X11BypassWindowManagerHint) &&
-        !tlw->testAttribute(Qt::WA_DontShowOnScreen) &&
-        !tlw->hasHeightForWidth()) {
-        QPlatformWindow *platformWindow = tlw->windowHandle()->handle();
-        const QPoint globalPos = QHighDpi::toNativePixels(
-            platformWindow->mapToGlobal(this->mapTo(tlw, event->pos())),
-            platformWindow->screen()->screen());
-
-        const xcb_atom_t moveResizeAtom = []() -> xcb_atom_t {
-            xcb_intern_atom_cookie_t cookie = xcb_intern_atom(
-                QX11Info::connection(),
-                false,
-                static_cast<std::uint16_t>(std::strlen(_NET_WM_MOVERESIZE)),
-                _NET_WM_MOVERESIZE);
-            xcb_intern_atom_reply_t *reply =
-                xcb_intern_atom_reply(QX11Info::connection(), cookie, nullptr);
-            const xcb_atom_t moveResizeAtomCopy = reply->atom;
-            free(reply);
-            return moveResizeAtomCopy;
-        }();
-
-        xcb_client_message_event_t xev;
-        xev.response_type = XCB_CLIENT_MESSAGE;
-        xev.type = moveResizeAtom;
-        xev.sequence = 0;
-        xev.window = static_cast<xcb_window_t>(platformWindow->winId());
-        xev.format = 32;
-        xev.data.data32[0] = static_cast<std::uint32_t>(globalPos.x());
-        xev.data.data32[1] = static_cast<std::uint32_t>(globalPos.y());
-        xev.data.data32[2] = 8; // move
-        xev.data.data32[3] = XCB_BUTTON_INDEX_1;
-        xev.data.data32[4] = 0;
-
-        const xcb_window_t rootWindow = [platformWindow]() -> xcb_window_t {
-            xcb_query_tree_cookie_t queryTreeCookie = xcb_query_tree(
-                QX11Info::connection(),
-                static_cast<xcb_window_t>(platformWindow->winId()));
-            xcb_query_tree_reply_t *queryTreeReply = xcb_query_tree_reply(
-                QX11Info::connection(), queryTreeCookie, nullptr);
-            xcb_window_t rootWindowCopy = queryTreeReply->root;
-            free(queryTreeReply);
-            return rootWindowCopy;
-        }();
-
-        std::uint32_t eventFlags = XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT |
-                                   XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY;
-
-        xcb_ungrab_pointer(QX11Info::connection(), XCB_CURRENT_TIME);
-        xcb_send_event(QX11Info::connection(),
-                       false,
-                       rootWindow,
-                       eventFlags,
-                       reinterpret_cast<const char *>(&xev));
+bool TitleBar::event(QEvent *event) {
+    if (event->type() == QEvent::Polish ||
+        event->type() == QEvent::StyleChange) {
+        this->updateBackgroundMode();
+    } else if (event->type() == QEvent::LayoutDirectionChange) {
+        this->layoutCaptionCluster();
+    } else if (event->type() == QEvent::LayoutRequest) {
+        // The layout has placed the menu bar by the time this arrives.
+        this->updateHitTestMap();
     }
+    return QWidget::event(event);
 }
-#endif
 
-void TitleBar::paintEvent([[maybe_unused]] QPaintEvent *event) {
+void TitleBar::resizeEvent(QResizeEvent *event) {
+    QWidget::resizeEvent(event);
+    this->placeCaptionCluster();
+}
+
+void TitleBar::moveEvent(QMoveEvent *event) {
+    QWidget::moveEvent(event);
+    this->updateHitTestMap();
+}
+
+void TitleBar::layoutCaptionCluster() {
+    const auto buttonWidth =
+        Internal::captionStyleInfo(this->m_captionButtonStyle).buttonWidth;
+    const auto height = this->maximumHeight();
+    // Hidden buttons are not laid out. Before the first show every child is
+    // hidden, so this goes by what setMinimizable() and setMaximizable() set.
+    const std::pair<TitleBarButton *, bool> buttons[] = {
+        {this->m_buttonMinimize, this->m_minimizable},
+        {this->m_buttonMaximizeRestore, this->m_maximizable},
+        {this->m_buttonClose, true},
+    };
+    auto width = 0;
+    for (const auto &[button, shown] : buttons) {
+        if (shown) {
+            width += buttonWidth;
+        }
+    }
+    const auto clusterRect = QRect(0, 0, width, height);
+    auto x = 0;
+    for (const auto &[button, shown] : buttons) {
+        if (shown) {
+            button->setGeometry(
+                QStyle::visualRect(this->layoutDirection(),
+                                   clusterRect,
+                                   QRect(x, 0, buttonWidth, height)));
+            x += buttonWidth;
+        }
+    }
+    this->m_captionCluster->resize(clusterRect.size());
+
+    // Keep the layout, and so the menu bar, clear of the cluster.
+    if (this->isRightToLeft()) {
+        this->m_horizontalLayout->setContentsMargins(width, 0, 0, 0);
+    } else {
+        this->m_horizontalLayout->setContentsMargins(0, 0, width, 0);
+    }
+    this->placeCaptionCluster();
+}
+
+void TitleBar::placeCaptionCluster() {
+    const auto x =
+        this->isRightToLeft()
+            ? 0
+            : this->width() - this->m_captionCluster->width();
+    this->m_captionCluster->move(x, 0);
+    this->updateHitTestMap();
+}
+
+void TitleBar::setHitTestMap(Internal::HitTestMap *map) {
+    this->m_hitTestMap = map;
+    this->updateHitTestMap();
+}
+
+void TitleBar::updateHitTestMap() {
+    if (this->m_hitTestMap == nullptr) {
+        return;
+    }
+    const auto *window = this->window();
+    const auto inWindow = [window](const QWidget *widget) {
+        if (widget == nullptr || widget->isHidden()) {
+            return QRect();
+        }
+        return QRect(widget->mapTo(window, QPoint()), widget->size());
+    };
+    this->m_hitTestMap->setCaption(inWindow(this),
+                                   {inWindow(this->m_buttonCaptionIcon),
+                                    inWindow(this->m_menuBar),
+                                    inWindow(this->m_captionCluster),
+                                    QRect()});
+}
+
+void TitleBar::updateBackgroundMode() {
+    // Without a style sheet PE_Widget draws nothing, so the background fill
+    // covers every pixel of the paint event.
+    const bool styled = this->testAttribute(Qt::WA_StyleSheetTarget);
+    this->setAttribute(Qt::WA_OpaquePaintEvent, !styled);
+    this->m_captionCluster->setAttribute(Qt::WA_OpaquePaintEvent, !styled);
+}
+
+void TitleBar::paintEvent(QPaintEvent *event) {
+    auto painter = QPainter(this);
+    painter.fillRect(event->rect(), this->backgroundColor());
+    if (!this->testAttribute(Qt::WA_StyleSheetTarget)) {
+        return;
+    }
     auto styleOption = QStyleOption();
     styleOption.init(this);
-    auto painter = QPainter(this);
     this->style()->drawPrimitive(
         QStyle::PE_Widget, &styleOption, &painter, this);
 }
@@ -324,27 +359,43 @@ bool TitleBar::isActive() const {
 }
 
 void TitleBar::setActive(bool active) {
-    this->m_active = active;
-    if (active) {
-        auto palette = this->palette();
-        palette.setColor(QPalette::Window, this->m_activeColor);
-        this->setPalette(palette);
-    } else {
-        auto palette = this->palette();
-        palette.setColor(QPalette::Window, this->m_inactiveColor);
-        this->setPalette(palette);
+    if (this->m_active == active) {
+        return;
     }
+    this->m_active = active;
+    this->repaintBackground();
+}
 
-    auto iconsPaths =
-        Internal::captionIconPathsForState(this->m_active,
-                                           this->m_maximized,
-                                           false,
-                                           false,
-                                           this->m_captionButtonStyle);
+QColor TitleBar::backgroundColor() const {
+    return this->m_active ? this->m_activeColor : this->m_inactiveColor;
+}
 
-    this->m_buttonMinimize->setIcon(QIcon(iconsPaths[0].toString()));
-    this->m_buttonMaximizeRestore->setIcon(QIcon(iconsPaths[1].toString()));
-    this->m_buttonClose->setIcon(QIcon(iconsPaths[2].toString()));
+void TitleBar::repaintBackground() {
+    if (this->m_updateDepth > 0) {
+        this->m_pendingChanges |= BackgroundChanged;
+        return;
+    }
+    if (!this->isVisibleOnScreen()) {
+        this->m_repaintPending = true;
+        return;
+    }
+    this->syncMenuBarColor();
+    this->update();
+}
+
+void TitleBar::syncMenuBarColor() {
+    // QMenuBar paints its background from its own palette. It is the only
+    // widget that gets one, and only when the color actually changes.
+    if (this->m_menuBar == nullptr) {
+        return;
+    }
+    const auto color = this->backgroundColor();
+    auto palette = this->m_menuBar->palette();
+    if (palette.color(QPalette::Window) == color) {
+        return;
+    }
+    palette.setColor(QPalette::Window, color);
+    this->m_menuBar->setPalette(palette);
 }
 
 bool TitleBar::isMaximized() const {
@@ -352,37 +403,46 @@ bool TitleBar::isMaximized() const {
 }
 
 void TitleBar::setMaximized(bool maximized) {
+    if (this->m_maximized == maximized) {
+        return;
+    }
     this->m_maximized = maximized;
-    auto iconsPaths =
-        Internal::captionIconPathsForState(this->m_active,
-                                           this->m_maximized,
-                                           false,
-                                           false,
-                                           this->m_captionButtonStyle);
-
-    this->m_buttonMinimize->setIcon(QIcon(iconsPaths[0].toString()));
-    this->m_buttonMaximizeRestore->setIcon(QIcon(iconsPaths[1].toString()));
-    this->m_buttonClose->setIcon(QIcon(iconsPaths[2].toString()));
+    this->triggerCaptionRepaint();
 }
 
 void TitleBar::setMinimizable(bool on) {
+    if (this->m_minimizable == on) {
+        return;
+    }
+    this->m_minimizable = on;
     this->m_buttonMinimize->setVisible(on);
+    this->layoutCaptionCluster();
 }
 
 void TitleBar::setMaximizable(bool on) {
+    if (this->m_maximizable == on) {
+        return;
+    }
+    this->m_maximizable = on;
     this->m_buttonMaximizeRestore->setVisible(on);
+    this->layoutCaptionCluster();
 }
 
 QColor TitleBar::activeColor() {
     return this->m_activeColor;
 }
 
-void TitleBar::setActiveColor(const QColor &inactiveColor) {
+void TitleBar::setActiveColor(const QColor &activeColor) {
 #ifdef _WIN32
     this->m_activeColorOverridden = true;
 #endif
-    this->m_activeColor = inactiveColor;
-    this->update();
+    if (this->m_activeColor == activeColor) {
+        return;
+    }
+    this->m_activeColor = activeColor;
+    if (this->m_active) {
+        this->repaintBackground();
+    }
 }
 
 QColor TitleBar::inactiveColor() {
@@ -390,8 +450,13 @@ QColor TitleBar::inactiveColor() {
 }
 
 void TitleBar::setInactiveColor(const QColor &inactiveColor) {
-    this->m_activeColor = inactiveColor;
-    this->update();
+    if (this->m_inactiveColor == inactiveColor) {
+        return;
+    }
+    this->m_inactiveColor = inactiveColor;
+    if (!this->m_active) {
+        this->repaintBackground();
+    }
 }
 
 QColor TitleBar::hoverColor() const {
@@ -399,11 +464,52 @@ QColor TitleBar::hoverColor() const {
 }
 
 void TitleBar::setHoverColor(QColor hoverColor) {
+    if (this->m_hoverColor == hoverColor) {
+        return;
+    }
     this->m_hoverColor = std::move(hoverColor);
     this->m_buttonMinimize->setHoverColor(this->m_hoverColor);
     this->m_buttonMaximizeRestore->setHoverColor(this->m_hoverColor);
 }
 
+QColor TitleBar::foregroundColor() const {
+    return this->m_foregroundColor;
+}
+
+void TitleBar::setForegroundColor(QColor foregroundColor) {
+    if (this->m_foregroundColor == foregroundColor) {
+        return;
+    }
+    this->m_foregroundColor = std::move(foregroundColor);
+    this->triggerCaptionRepaint();
+}
+
+QColor TitleBar::inactiveForegroundColor() const {
+    return this->m_inactiveForegroundColor;
+}
+
+void TitleBar::setInactiveForegroundColor(QColor inactiveForegroundColor) {
+    if (this->m_inactiveForegroundColor == inactiveForegroundColor) {
+        return;
+    }
+    this->m_inactiveForegroundColor = std::move(inactiveForegroundColor);
+    this->triggerCaptionRepaint();
+}
+
+QColor TitleBar::captionGlyphColor(Internal::CaptionGlyphTone tone) const {
+    switch (tone) {
+    case Internal::CaptionGlyphTone::Normal:
+        return this->m_foregroundColor;
+    case Internal::CaptionGlyphTone::Inactive:
+        return this->m_inactiveForegroundColor;
+    case Internal::CaptionGlyphTone::Highlight:
+        return Qt::white;
+    case Internal::CaptionGlyphTone::None:
+        break;
+    }
+    return QColor();
+}
+
 CaptionButtonStyle TitleBar::captionButtonStyle() const {
     return this->m_captionButtonStyle;
 }
@@ -411,24 +517,10 @@ CaptionButtonStyle TitleBar::captionButtonStyle() const {
 void TitleBar::setCaptionButtonStyle(CaptionButtonStyle captionButtonStyle) {
     this->m_captionButtonStyle = captionButtonStyle;
 
-    auto iconSize = this->m_captionButtonStyle == CaptionButtonStyle::mac
-                        ? QSize(16, 16)
-                        : QSize(12, 12);
-    int requiredWidth = 0;
-    switch (this->m_captionButtonStyle) {
-    case CaptionButtonStyle::custom: {
-        requiredWidth = 30;
-        break;
-    }
-    case CaptionButtonStyle::win: {
-        requiredWidth = 46;
-        break;
-    }
-    case CaptionButtonStyle::mac: {
-        requiredWidth = 26;
-        break;
-    }
-    }
+    const auto iconSize =
+        Internal::captionIconSize(this->m_captionButtonStyle);
+    const auto requiredWidth =
+        Internal::captionStyleInfo(this->m_captionButtonStyle).buttonWidth;
     this->m_buttonMinimize->setIconSize(iconSize);
     this->m_buttonMinimize->setMinimumWidth(requiredWidth);
     this->m_buttonMinimize->setMaximumWidth(requiredWidth);
@@ -438,43 +530,67 @@ void TitleBar::setCaptionButtonStyle(CaptionButtonStyle captionButtonStyle) {
     this->m_buttonClose->setIconSize(iconSize);
     this->m_buttonClose->setMinimumWidth(requiredWidth);
     this->m_buttonClose->setMaximumWidth(requiredWidth);
+    this->layoutCaptionCluster();
 
-    auto iconsPaths =
-        Internal::captionIconPathsForState(this->m_active,
-                                           this->m_maximized,
-                                           false,
-                                           false,
-                                           this->m_captionButtonStyle);
-
-    this->m_buttonMinimize->setIcon(QIcon(iconsPaths[0].toString()));
-    this->m_buttonMaximizeRestore->setIcon(QIcon(iconsPaths[1].toString()));
-    this->m_buttonClose->setIcon(QIcon(iconsPaths[2].toString()));
+    this->triggerCaptionRepaint();
 }
 
 void TitleBar::onWindowStateChange(Qt::WindowStates state) {
-    this->setActive(this->window()->isActiveWindow());
+    this->beginUpdate();
+    const bool wasVisible = this->isVisibleOnScreen();
+    this->m_minimized = static_cast<bool>(state & Qt::WindowMinimized);
+    this->onScreenVisibilityChanged(wasVisible);
     this->setMaximized(static_cast<bool>(state & Qt::WindowMaximized));
+    this->commitUpdate();
 }
 
-bool TitleBar::hovered() const {
-    auto cursorPos = QCursor::pos();
-    bool hovered = this->rect().contains(this->mapFromGlobal(cursorPos));
-    if (!hovered) {
-        return false;
-    }
+void TitleBar::beginUpdate() {
+    ++this->m_updateDepth;
+}
 
-    if (this->m_menuBar->rect().contains(
-            this->m_menuBar->mapFromGlobal(cursorPos))) {
-        return false;
+void TitleBar::commitUpdate() {
+    Q_ASSERT(this->m_updateDepth > 0);
+    if (--this->m_updateDepth > 0) {
+        return;
     }
+    const auto changes = this->m_pendingChanges;
+    this->m_pendingChanges = 0;
+    // A background repaint covers the caption buttons as well.
+    if (changes & BackgroundChanged) {
+        this->repaintBackground();
+    } else if (changes & CaptionChanged) {
+        this->triggerCaptionRepaint();
+    }
+}
 
-    for (const TitleBarButton *btn : this->findChildren<TitleBarButton *>()) {
-        bool btnHovered = btn->rect().contains(btn->mapFromGlobal(cursorPos));
-        if (btnHovered) {
-            return false;
-        }
+bool TitleBar::isVisibleOnScreen() const {
+    return this->m_visibleOnScreen && !this->m_minimized;
+}
+
+void TitleBar::setVisibleOnScreen(bool visible) {
+    const bool wasVisible = this->isVisibleOnScreen();
+    this->m_visibleOnScreen = visible;
+    this->onScreenVisibilityChanged(wasVisible);
+}
+
+void TitleBar::onScreenVisibilityChanged(bool wasVisible) {
+    const bool visible = this->isVisibleOnScreen();
+    if (visible == wasVisible) {
+        return;
+    }
+    if (!visible) {
+        // Nobody sees the fades, jump to where they would end.
+        auto &fadeDriver = Internal::HoverFadeDriver::instance();
+        fadeDriver.settle(this->m_buttonMinimize);
+        fadeDriver.settle(this->m_buttonMaximizeRestore);
+        fadeDriver.settle(this->m_buttonClose);
+        return;
+    }
+    if (this->m_repaintPending) {
+        this->m_repaintPending = false;
+        this->syncMenuBarColor();
+        this->update();
     }
-    return true;
 }
 
 bool TitleBar::isCaptionButtonHovered() const {
@@ -484,120 +600,21 @@ bool TitleBar::isCaptionButtonHovered() const {
 }
 
 void TitleBar::triggerCaptionRepaint() {
-    this->m_buttonMinimize->update();
-    this->m_buttonMaximizeRestore->update();
-    this->m_buttonClose->update();
-}
-
-namespace Internal {
-
-std::array<QStringView, 3> captionIconPathsForState(bool active,
-                                                    bool maximized,
-                                                    bool hovered,
-                                                    bool pressed,
-                                                    CaptionButtonStyle style) {
-    std::array<QStringView, 3> buf;
-
-    switch (style) {
-    case CaptionButtonStyle::custom: {
-        if (active || hovered) {
-            buf[0] = u":/resources/titlebar/custom/chrome-minimize-dark.svg";
-            if (maximized) {
-                buf[1] =
-                    u":/resources/titlebar/custom/chrome-restore-dark.svg";
-            } else {
-                buf[1] =
-                    u":/resources/titlebar/custom/chrome-maximize-dark.svg";
-            }
-            if (hovered) {
-                buf[2] = u":/resources/titlebar/custom/chrome-close-light.svg";
-            } else {
-                buf[2] = u":/resources/titlebar/custom/chrome-close-dark.svg";
-            }
-        } else {
-            buf[0] = u":/resources/titlebar/custom/"
-                     u"chrome-minimize-dark-disabled.svg";
-            if (maximized) {
-                buf[1] = u":/resources/titlebar/custom/"
-                         u"chrome-restore-dark-disabled.svg";
-            } else {
-                buf[1] = u":/resources/titlebar/custom/"
-                         u"chrome-maximize-dark-disabled.svg";
-            }
-            buf[2] =
-                u":/resources/titlebar/custom/chrome-close-dark-disabled.svg";
-        }
-        break;
-    }
-    case CaptionButtonStyle::win: {
-        if (active || hovered) {
-            buf[0] = u":/resources/titlebar/win/chrome-minimize-dark.svg";
-            if (maximized) {
-                buf[1] = u":/resources/titlebar/win/chrome-restore-dark.svg";
-            } else {
-                buf[1] = u":/resources/titlebar/win/chrome-maximize-dark.svg";
-            }
-            if (hovered) {
-                buf[2] = u":/resources/titlebar/win/chrome-close-light.svg";
-            } else {
-                buf[2] = u":/resources/titlebar/win/chrome-close-dark.svg";
-            }
-        } else {
-            buf[0] =
-                u":/resources/titlebar/win/chrome-minimize-dark-disabled.svg";
-            if (maximized) {
-                buf[1] = u":/resources/titlebar/win/"
-                         u"chrome-restore-dark-disabled.svg";
-            } else {
-                buf[1] = u":/resources/titlebar/win/"
-                         u"chrome-maximize-dark-disabled.svg";
-            }
-            buf[2] =
-                u":/resources/titlebar/win/chrome-close-dark-disabled.svg";
-        }
-        break;
-    }
-    case CaptionButtonStyle::mac: {
-        if (pressed) {
-            buf[0] = u":/resources/titlebar/mac/minimize-pressed.png";
-            if (maximized) {
-                buf[1] = u":/resources/titlebar/mac/"
-                         "maximize-restore-maximized-pressed.png";
-            } else {
-                buf[1] = u":/resources/titlebar/mac/"
-                         u"maximize-restore-normal-pressed.png";
-            }
-            buf[2] = u":/resources/titlebar/mac/close-pressed.png";
-        } else {
-            if (hovered) {
-                buf[0] = u":/resources/titlebar/mac/minimize-hovered.png";
-                if (maximized) {
-                    buf[1] = u":/resources/titlebar/mac/"
-                             u"maximize-restore-maximized-hovered.png";
-                } else {
-                    buf[1] = u":/resources/titlebar/mac/"
-                             u"maximize-restore-normal-hovered.png";
-                }
-                buf[2] = u":/resources/titlebar/mac/close-hovered.png";
-            } else {
-                if (active) {
-                    buf[0] = u":/resources/titlebar/mac/minimize.png";
-                    buf[1] = u":/resources/titlebar/mac/maximize-restore.png";
-                    buf[2] = u":/resources/titlebar/mac/close.png";
-                } else {
-                    buf[0] = u":/resources/titlebar/mac/inactive.png";
-                    buf[1] = u":/resources/titlebar/mac/inactive.png";
-                    buf[2] = u":/resources/titlebar/mac/inactive.png";
-                }
-            }
-        }
-        break;
-    }
+    if (this->m_updateDepth > 0) {
+        this->m_pendingChanges |= CaptionChanged;
+        return;
     }
-
-    return buf;
+    this->m_buttonMinimize->updateVisualState();
+    this->m_buttonMaximizeRestore->updateVisualState();
+    this->m_buttonClose->updateVisualState();
 }
 
-} // namespace Internal
+void TitleBar::repaintCaptionButton(TitleBarButton *button) {
+    if (!this->isVisibleOnScreen()) {
+        this->m_repaintPending = true;
+        return;
+    }
+    button->update();
+}
 
 } // namespace CSD
@@ -1,15 +1,13 @@
 #pragma once
 
 #include "captionbuttonstyle.h"
+#include "csdcaptionicons.h"
+#include "csdtitlebarclient.h"
 
 #include <QColor>
 #include <QIcon>
-#include <QStringView>
 #include <QWidget>
 
-#include <array>
-#include <optional>
-
 class QHBoxLayout;
 class QLayout;
 class QLabel;
@@ -23,7 +21,7 @@ namespace CSD {
 
 class TitleBarButton;
 
-class TitleBar : public QWidget {
+class TitleBar : public QWidget, public Internal::TitleBarClient {
     Q_OBJECT
     Q_PROPERTY(bool active READ isActive WRITE setActive)
     Q_PROPERTY(bool maximized READ isMaximized WRITE setMaximized)
@@ -32,27 +30,53 @@ private:
 #ifdef _WIN32
     bool m_activeColorOverridden = false;
     QRegistryWatcher *m_watcher = nullptr;
-    std::optional<QColor> readDWMColorizationColor();
 #endif
     bool m_active = false;
     bool m_maximized = false;
+    bool m_minimized = false;
+    bool m_minimizable = true;
+    bool m_maximizable = true;
+    bool m_visibleOnScreen = true;
+    bool m_repaintPending = false;
+    // Changes held back by an open beginUpdate().
+    enum PendingChange {
+        BackgroundChanged = 0x1,
+        CaptionChanged = 0x2,
+    };
+    int m_updateDepth = 0;
+    int m_pendingChanges = 0;
     QColor m_activeColor = Qt::black;
     QColor m_inactiveColor = Qt::white;
     QColor m_hoverColor = Qt::gray;
+    QColor m_foregroundColor = QColor(0xAB, 0xB2, 0xBF);
+    QColor m_inactiveForegroundColor = QColor(0x5C, 0x63, 0x70);
     QHBoxLayout *m_horizontalLayout;
-    QMenuBar *m_menuBar;
+    QMenuBar *m_menuBar = nullptr;
     QWidget *m_leftMargin;
     CaptionButtonStyle m_captionButtonStyle;
     TitleBarButton *m_buttonCaptionIcon;
     TitleBarButton *m_buttonMinimize;
     TitleBarButton *m_buttonMaximizeRestore;
     TitleBarButton *m_buttonClose;
+    QWidget *m_captionCluster;
+    Internal::HitTestMap *m_hitTestMap = nullptr;
+
+    void repaintBackground();
+    void syncMenuBarColor();
+    void onScreenVisibilityChanged(bool wasVisible);
+    void updateBackgroundMode();
+    void layoutCaptionCluster();
+    void placeCaptionCluster();
+    void updateHitTestMap();
 
 protected:
 #if !defined(_WIN32) && !defined(__APPLE__)
     void mousePressEvent(QMouseEvent *event) override;
 #endif
+    bool event(QEvent *event) override;
     void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void moveEvent(QMoveEvent *event) override;
 
 public:
     explicit TitleBar(CaptionButtonStyle captionButtonStyle,
@@ -61,24 +85,45 @@ public:
     ~TitleBar() override;
 
     bool isActive() const;
-    void setActive(bool active);
+    void setActive(bool active) override;
     bool isMaximized() const;
     void setMaximized(bool maximized);
     void setMinimizable(bool on);
     void setMaximizable(bool on);
     QColor activeColor();
-    void setActiveColor(const QColor &inactiveColor);
+    void setActiveColor(const QColor &activeColor);
     QColor inactiveColor();
     void setInactiveColor(const QColor &inactiveColor);
+    // The color the background is painted with, depending on isActive().
+    QColor backgroundColor() const;
     QColor hoverColor() const;
     void setHoverColor(QColor hoverColor);
+    QColor foregroundColor() const;
+    void setForegroundColor(QColor foregroundColor);
+    QColor inactiveForegroundColor() const;
+    void setInactiveForegroundColor(QColor inactiveForegroundColor);
+    QColor captionGlyphColor(Internal::CaptionGlyphTone tone) const;
     CaptionButtonStyle captionButtonStyle() const;
     void setCaptionButtonStyle(CaptionButtonStyle captionButtonStyle);
-    void onWindowStateChange(Qt::WindowStates state);
-    bool hovered() const;
+    void onWindowStateChange(Qt::WindowStates state) override;
+    // Between beginUpdate() and the matching commitUpdate(), state and color
+    // setters only record what changed. The outermost commitUpdate() then
+    // schedules a single repaint for all of it. Calls nest.
+    void beginUpdate();
+    void commitUpdate();
+    // Keeps the caption part of map, in window coordinates, up to date
+    // while the title bar is laid out, moved and resized. Set by the
+    // platform filter of the window; may be null.
+    void setHitTestMap(Internal::HitTestMap *map) override;
+
+    // False while the window is minimized or the platform reports it as
+    // hidden or fully obscured. Repaints are held back until it shows again.
+    bool isVisibleOnScreen() const;
+    void setVisibleOnScreen(bool visible) override;
 
     bool isCaptionButtonHovered() const;
     void triggerCaptionRepaint();
+    void repaintCaptionButton(TitleBarButton *button);
 
 signals:
     void minimizeClicked();
@@ -86,14 +131,4 @@ signals:
     void closeClicked();
 };
 
-namespace Internal {
-
-std::array<QStringView, 3> captionIconPathsForState(bool active,
-                                                    bool maximized,
-                                                    bool hovered,
-                                                    bool pressed,
-                                                    CaptionButtonStyle style);
-
-}
-
 } // namespace CSD
@@ -1,9 +1,10 @@
 #include "csdtitlebarbutton.h"
 
+#include "csdfadedriver.h"
+#include "csdiconcache.h"
 #include "csdtitlebar.h"
 
 #include <QEvent>
-#include <QPropertyAnimation>
 #include <QStyleOption>
 #include <QStylePainter>
 
@@ -21,17 +22,29 @@ TitleBarButton::TitleBarButton(const QIcon &icon,
                                const QString &text,
                                Role role,
                                TitleBar *parent)
-    : QPushButton(icon, text, parent), m_role(role) {
+    : QPushButton(icon, text, parent), m_role(role), m_titleBar(parent) {
     this->setAttribute(Qt::WidgetAttribute::WA_Hover, true);
 }
 
+TitleBarButton::~TitleBarButton() {
+    Internal::HoverFadeDriver::instance().cancel(this);
+}
+
+double TitleBarButton::fadeValue([[maybe_unused]] int slot) const {
+    return this->m_fader;
+}
+
+void TitleBarButton::setFadeValue([[maybe_unused]] int slot, double value) {
+    this->setFader(value);
+}
+
 double TitleBarButton::fader() const {
     return this->m_fader;
 }
 
 void TitleBarButton::setFader(double value) {
     this->m_fader = value;
-    this->update();
+    this->updateVisualState();
 }
 
 QColor TitleBarButton::hoverColor() const {
@@ -48,120 +61,197 @@ bool TitleBarButton::keepDown() const {
 
 void TitleBarButton::setKeepDown(bool keepDown) {
     this->m_keepDown = keepDown;
-    this->update();
+    this->updateVisualState();
+}
+
+void TitleBarButton::updateVisualState() {
+    if (this->m_paintedState.has_value() &&
+        *this->m_paintedState == this->visualState()) {
+        return;
+    }
+    this->m_titleBar->repaintCaptionButton(this);
 }
 
 bool TitleBarButton::event(QEvent *event) {
+    if (event->type() == QEvent::Polish ||
+        event->type() == QEvent::StyleChange) {
+        this->updateBackgroundMode();
+    }
     if (this->isDown()) {
         return QPushButton::event(event);
     }
     switch (event->type()) {
-    case QEvent::Enter: {
-        auto animation = new QPropertyAnimation(this, "fader");
-        animation->setDuration(125);
-        animation->setEndValue(1.0);
-        animation->start(QAbstractAnimation::DeleteWhenStopped);
+    case QEvent::Enter:
+        this->fadeTo(1.0);
         break;
-    }
-    case QEvent::Leave: {
-        auto animation = new QPropertyAnimation(this, "fader");
-        animation->setDuration(125);
-        animation->setEndValue(0.0);
-        animation->start(QAbstractAnimation::DeleteWhenStopped);
+    case QEvent::Leave:
+        this->fadeTo(0.0);
         break;
-    }
     default:
         break;
     }
     return QPushButton::event(event);
 }
 
-void TitleBarButton::paintEvent([[maybe_unused]] QPaintEvent *event) {
-    auto *titleBar = static_cast<TitleBar *>(this->parent());
+void TitleBarButton::updateBackgroundMode() {
+    // The button can paint the title bar background itself, and so every
+    // pixel, unless a style sheet draws either of them.
+    this->setAttribute(
+        Qt::WA_OpaquePaintEvent,
+        !this->testAttribute(Qt::WA_StyleSheetTarget) &&
+            !this->m_titleBar->testAttribute(Qt::WA_StyleSheetTarget));
+}
 
-    auto stylePainter = QStylePainter(this);
-    auto styleOptionButton = QStyleOptionButton();
-    styleOptionButton.initFrom(this);
-    styleOptionButton.features = QStyleOptionButton::None;
-    styleOptionButton.text = this->text();
-    styleOptionButton.icon = this->icon();
-    styleOptionButton.iconSize = this->iconSize();
-
-    const auto hoverColor = [titleBar, this]() -> QColor {
-        auto col = this->m_role == Role::Close ? QColor(232, 17, 35, 229)
-                                               : this->m_hoverColor;
-        if (!this->m_keepDown) {
-            col.setAlpha(static_cast<int>(this->m_fader * col.alpha()));
-        }
-
-        bool isMacCaptionStyle =
-            titleBar->captionButtonStyle() == CaptionButtonStyle::mac;
-        bool isMacCaptionButton =
-            (isMacCaptionStyle && this->m_role == Role::Minimize) ||
-            (isMacCaptionStyle && this->m_role == Role::MaximizeRestore) ||
-            (isMacCaptionStyle && this->m_role == Role::Close);
-
-        if (!this->isEnabled() || this->m_role == Role::CaptionIcon ||
-            isMacCaptionButton) {
-            col.setAlpha(0);
-        }
-
-        return col;
-    }();
+void TitleBarButton::fadeTo(double target) {
+    auto &fadeDriver = Internal::HoverFadeDriver::instance();
+    if (this->m_titleBar->isVisibleOnScreen()) {
+        fadeDriver.fadeTo(this, 0, target);
+    } else {
+        fadeDriver.cancel(this);
+        this->setFader(target);
+    }
+}
+
+Internal::CaptionButtonVisual TitleBarButton::visualState() const {
+    auto *titleBar = this->m_titleBar;
+    auto state = Internal::CaptionButtonVisual();
+    state.style = titleBar->captionButtonStyle();
+    state.enabled = this->isEnabled();
+    state.background = Internal::captionButtonBackground(state.style,
+                                                         this->m_role,
+                                                         state.enabled,
+                                                         this->m_hoverColor,
+                                                         this->m_fader,
+                                                         this->m_keepDown);
+    if (this->m_role == Role::CaptionIcon) {
+        return state;
+    }
 
     // On mac style, all caption buttons get the 'hovered' style if any of them
     // is hovered - this mimics real macOS
     const bool isHovered =
-        (styleOptionButton.state & QStyle::State_MouseOver) ||
-        (titleBar->captionButtonStyle() == CaptionButtonStyle::mac &&
-         titleBar->isCaptionButtonHovered());
-
-    const auto iconPaths =
-        Internal::captionIconPathsForState(titleBar->isActive(),
-                                           titleBar->isMaximized(),
-                                           isHovered,
-                                           this->isDown(),
-                                           titleBar->captionButtonStyle());
-
-    switch (this->m_role) {
-    case Role::CaptionIcon: {
-        break;
-    }
-    case Role::Minimize: {
-        if (isHovered) {
-            styleOptionButton.icon = QIcon(iconPaths[0].toString());
-        }
-        break;
-    }
-    case Role::MaximizeRestore: {
-        if (isHovered) {
-            styleOptionButton.icon = QIcon(iconPaths[1].toString());
-        }
-        break;
-    }
-    case Role::Close: {
-        if (isHovered) {
-            styleOptionButton.icon = QIcon(iconPaths[2].toString());
-        }
-        break;
-    }
+        this->underMouse() || (state.style == CaptionButtonStyle::mac &&
+                               titleBar->isCaptionButtonHovered());
+
+    state.states.setFlag(Internal::CaptionButtonActive, titleBar->isActive());
+    state.states.setFlag(Internal::CaptionButtonMaximized,
+                         titleBar->isMaximized());
+    state.states.setFlag(Internal::CaptionButtonHovered, isHovered);
+    state.states.setFlag(Internal::CaptionButtonPressed,
+                         isHovered && this->isDown());
+
+    const auto tone =
+        Internal::captionIcon(state.style,
+                              static_cast<std::size_t>(this->m_role) - 1,
+                              state.states)
+            .tone;
+    state.tint = titleBar->captionGlyphColor(tone).rgba();
+    return state;
+}
+
+void TitleBarButton::paintEvent([[maybe_unused]] QPaintEvent *event) {
+    const auto state = this->visualState();
+    this->m_paintedState = state;
+
+    auto stylePainter = QStylePainter(this);
+    if (this->testAttribute(Qt::WA_OpaquePaintEvent)) {
+        stylePainter.fillRect(this->rect(),
+                              this->m_titleBar->backgroundColor());
     }
+    Internal::paintCaptionButton(
+        stylePainter, this->rect(), this->m_role, state, this);
 
-    stylePainter.setRenderHint(QPainter::Antialiasing, false);
-    stylePainter.setPen(Qt::NoPen);
-    stylePainter.setBrush(QBrush(hoverColor));
-    stylePainter.drawRect(styleOptionButton.rect);
-    stylePainter.drawControl(QStyle::CE_PushButtonLabel, styleOptionButton);
+    if (this->m_role == Role::CaptionIcon) {
+        auto styleOptionButton = QStyleOptionButton();
+        styleOptionButton.initFrom(this);
+        styleOptionButton.features = QStyleOptionButton::None;
+        styleOptionButton.text = this->text();
+        styleOptionButton.icon = this->icon();
+        styleOptionButton.iconSize = this->iconSize();
+        stylePainter.drawControl(QStyle::CE_PushButtonLabel,
+                                 styleOptionButton);
+    }
 }
 
 void TitleBarButton::enterEvent(QEvent *event) {
     QPushButton::enterEvent(event);
-    static_cast<TitleBar *>(this->parent())->triggerCaptionRepaint();
+    this->m_titleBar->triggerCaptionRepaint();
 }
 
 void TitleBarButton::leaveEvent(QEvent *event) {
     QPushButton::leaveEvent(event);
-    static_cast<TitleBar *>(this->parent())->triggerCaptionRepaint();
+    this->m_titleBar->triggerCaptionRepaint();
+}
+
+namespace Internal {
+
+bool CaptionButtonVisual::operator==(const CaptionButtonVisual &other) const {
+    return this->background == other.background && this->tint == other.tint &&
+           this->states == other.states && this->style == other.style &&
+           this->enabled == other.enabled;
+}
+
+bool CaptionButtonVisual::operator!=(const CaptionButtonVisual &other) const {
+    return !(*this == other);
 }
 
+QRgb captionButtonBackground(CaptionButtonStyle style,
+                             TitleBarButton::Role role,
+                             bool enabled,
+                             QColor hoverColor,
+                             double fader,
+                             bool keepDown) {
+    if (!enabled || role == TitleBarButton::CaptionIcon ||
+        style == CaptionButtonStyle::mac) {
+        return 0;
+    }
+    auto color =
+        role == TitleBarButton::Close ? QColor(232, 17, 35, 229) : hoverColor;
+    if (!keepDown) {
+        color.setAlpha(static_cast<int>(fader * color.alpha()));
+    }
+    return color.rgba();
+}
+
+void paintCaptionButton(QPainter &painter,
+                        const QRect &rect,
+                        TitleBarButton::Role role,
+                        const CaptionButtonVisual &visual,
+                        const QWidget *widget) {
+    if (qAlpha(visual.background) != 0) {
+        painter.fillRect(rect, QColor::fromRgba(visual.background));
+    }
+    if (role == TitleBarButton::CaptionIcon) {
+        return;
+    }
+
+    const auto devicePixelRatio = widget->devicePixelRatioF();
+    const auto image = CaptionIconCache::instance().image(visual.style,
+                                                          role,
+                                                          visual.states,
+                                                          devicePixelRatio,
+                                                          visual.tint);
+    if (image.isNull()) {
+        return;
+    }
+
+    const auto iconRect = QStyle::alignedRect(
+        widget->layoutDirection(),
+        Qt::AlignCenter,
+        (QSizeF(image.size()) / devicePixelRatio).toSize(),
+        rect);
+    if (visual.enabled) {
+        painter.drawImage(iconRect, image);
+    } else {
+        auto option = QStyleOption();
+        option.initFrom(widget);
+        painter.drawPixmap(
+            iconRect,
+            widget->style()->generatedIconPixmap(
+                QIcon::Disabled, QPixmap::fromImage(image), &option));
+    }
+}
+
+} // namespace Internal
+
 } // namespace CSD
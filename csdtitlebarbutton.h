@@ -1,12 +1,37 @@
 #pragma once
 
+#include "captionbuttonstyle.h"
+#include "csdcaptionicons.h"
+#include "csdfadedriver.h"
+
 #include <QPushButton>
 
+#include <optional>
+
+class QPainter;
+
 namespace CSD {
 
 class TitleBar;
 
-class TitleBarButton : public QPushButton {
+namespace Internal {
+
+// Everything needed to paint a caption button, resolved from the button and
+// title bar state. Two equal visuals paint the same pixels.
+struct CaptionButtonVisual {
+    QRgb background = 0;
+    QRgb tint = 0;
+    CaptionButtonStates states;
+    CaptionButtonStyle style = CaptionButtonStyle::custom;
+    bool enabled = true;
+
+    bool operator==(const CaptionButtonVisual &other) const;
+    bool operator!=(const CaptionButtonVisual &other) const;
+};
+
+} // namespace Internal
+
+class TitleBarButton : public QPushButton, public Internal::FadeClient {
     Q_OBJECT
     Q_PROPERTY(double fader READ fader WRITE setFader)
     Q_PROPERTY(bool keepDown READ keepDown WRITE setKeepDown)
@@ -23,6 +48,7 @@ public:
                             const QString &text,
                             Role role,
                             TitleBar *parent = nullptr);
+    ~TitleBarButton() override;
 
     double fader() const;
     void setFader(double value);
@@ -30,6 +56,9 @@ public:
     void setHoverColor(QColor hoverColor);
     bool keepDown() const;
     void setKeepDown(bool keepDown);
+    // Schedules a repaint if the button would look different from the last
+    // time it was painted.
+    void updateVisualState();
 
 protected:
     bool event(QEvent *event) override;
@@ -38,10 +67,41 @@ protected:
     void leaveEvent(QEvent *event) override;
 
 private:
+    double fadeValue(int slot) const override;
+    void setFadeValue(int slot, double value) override;
+    void fadeTo(double target);
+    void updateBackgroundMode();
+    Internal::CaptionButtonVisual visualState() const;
+
     Role m_role;
+    // The button may be reparented into a container of the title bar.
+    TitleBar *m_titleBar;
+    std::optional<Internal::CaptionButtonVisual> m_paintedState;
     double m_fader = 0.0;
     QColor m_hoverColor = Qt::gray;
     bool m_keepDown = false;
 };
 
+namespace Internal {
+
+// Background of a caption button: hoverColor faded by fader, or the close
+// button red, and fully transparent where the style shows no background.
+QRgb captionButtonBackground(CaptionButtonStyle style,
+                             TitleBarButton::Role role,
+                             bool enabled,
+                             QColor hoverColor,
+                             double fader,
+                             bool keepDown);
+
+// Paints the background and, except for the caption icon, the glyph of a
+// caption button into rect. widget supplies the device pixel ratio, layout
+// direction and style.
+void paintCaptionButton(QPainter &painter,
+                        const QRect &rect,
+                        TitleBarButton::Role role,
+                        const CaptionButtonVisual &visual,
+                        const QWidget *widget);
+
+} // namespace Internal
+
 } // namespace CSD
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <Qt>
+
+namespace CSD::Internal {
+
+class HitTestMap;
+
+// What the platform filters tell a title bar directly, without callbacks.
+// Implemented by TitleBar and PaintedTitleBar.
+class TitleBarClient {
+public:
+    virtual void setActive(bool active) = 0;
+    // Activation is not part of the window state; the platform filters
+    // report it through setActive() as they learn of it.
+    virtual void onWindowStateChange(Qt::WindowStates state) = 0;
+    // False while the window is minimized or the platform reports it as
+    // hidden or fully obscured.
+    virtual void setVisibleOnScreen(bool visible) = 0;
+    // Keeps the caption part of map, in window coordinates, up to date
+    // while the title bar is laid out, moved and resized; may be null.
+    virtual void setHitTestMap(HitTestMap *map) = 0;
+
+protected:
+    ~TitleBarClient() = default;
+};
+
+} // namespace CSD::Internal
@@ -0,0 +1,95 @@
+#include "csdwindowshadow.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QRect>
+#include <qdrawutil.h>
+
+#include <cmath>
+
+QT_BEGIN_NAMESPACE
+// Defined in QtWidgets, used by QGraphicsBlurEffect.
+extern Q_WIDGETS_EXPORT void qt_blurImage(QPainter *painter,
+                                          QImage &blurImage,
+                                          qreal radius,
+                                          bool quality,
+                                          bool alphaOnly,
+                                          int transposed = 0);
+QT_END_NAMESPACE
+
+namespace CSD::Internal {
+
+WindowShadowCache &WindowShadowCache::instance() {
+    static auto cache = WindowShadowCache();
+    return cache;
+}
+
+void WindowShadowCache::paint(QPainter &painter,
+                              const QRect &rect,
+                              int radius,
+                              const QColor &color) {
+    if (radius <= 0) {
+        return;
+    }
+    const auto dpr = painter.device()->devicePixelRatioF();
+    const auto key =
+        static_cast<quint64>(color.rgba()) |
+        (static_cast<quint64>(radius) << 32u) |
+        (static_cast<quint64>(std::lround(dpr * 100)) << 48u);
+    auto it = this->m_tiles.constFind(key);
+    if (it == this->m_tiles.constEnd()) {
+        ++this->m_misses;
+        it = this->m_tiles.insert(key, render(radius, color, dpr));
+    } else {
+        ++this->m_hits;
+    }
+
+    // The tiles are four radii wide: the blur fades out over the outer two
+    // and reaches full strength under the content over the inner two.
+    const auto border = 2 * radius;
+    const auto margins = QMargins(border, border, border, border);
+    qDrawBorderPixmap(&painter,
+                      rect,
+                      margins,
+                      *it,
+                      it->rect(),
+                      margins,
+                      QTileRules(),
+                      QDrawBorderPixmap::OmitMiddle);
+}
+
+void WindowShadowCache::clear() {
+    this->m_tiles.clear();
+}
+
+quint64 WindowShadowCache::hits() const {
+    return this->m_hits;
+}
+
+quint64 WindowShadowCache::misses() const {
+    return this->m_misses;
+}
+
+QPixmap WindowShadowCache::render(int radius, const QColor &color, qreal dpr) {
+    const auto size = static_cast<int>(std::ceil(4 * radius * dpr));
+    const auto inset = static_cast<int>(std::lround(radius * dpr));
+    auto image = QImage(size, size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    {
+        auto painter = QPainter(&image);
+        painter.fillRect(
+            QRect(inset, inset, size - 2 * inset, size - 2 * inset), color);
+    }
+    // Blurs in place; the painter is only needed to draw the result.
+    auto blurred = QImage(image.size(), QImage::Format_ARGB32_Premultiplied);
+    blurred.fill(Qt::transparent);
+    {
+        auto painter = QPainter(&blurred);
+        qt_blurImage(&painter, image, radius * dpr, true, false);
+    }
+    auto pixmap = QPixmap::fromImage(blurred);
+    pixmap.setDevicePixelRatio(dpr);
+    return pixmap;
+}
+
+} // namespace CSD::Internal
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QColor>
+#include <QHash>
+#include <QPixmap>
+
+class QPainter;
+class QRect;
+
+namespace CSD::Internal {
+
+// Process-wide store of blurred window shadows. A shadow is blurred once per
+// radius, color and device pixel ratio into a small 9-patch; painting a
+// window's shadow only stretches its edges.
+class WindowShadowCache {
+public:
+    static WindowShadowCache &instance();
+
+    // Paints the shadow of content inset by radius on every side of rect.
+    // The content area itself is left untouched.
+    void paint(QPainter &painter,
+               const QRect &rect,
+               int radius,
+               const QColor &color);
+    void clear();
+
+    quint64 hits() const;
+    quint64 misses() const;
+
+private:
+    WindowShadowCache() = default;
+
+    static QPixmap render(int radius, const QColor &color, qreal dpr);
+
+    // Keyed by the color in the low 32 bits, the radius and the device pixel
+    // ratio in percent in the high ones.
+    QHash<quint64, QPixmap> m_tiles;
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+};
+
+} // namespace CSD::Internal
@@ -0,0 +1,86 @@
+#include "linuxatoms.h"
+
+#include <QX11Info>
+
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+namespace CSD::Internal {
+
+static quint64 s_x11RoundTrips = 0;
+
+// Indexed by X11Atom.
+constexpr static const char *kAtomNames[] = {
+    "_NET_WM_STATE",
+    "_NET_WM_STATE_HIDDEN",
+    "_NET_WM_STATE_MAXIMIZED_VERT",
+    "_NET_WM_STATE_MAXIMIZED_HORZ",
+    "_NET_WM_STATE_FULLSCREEN",
+    "_NET_WM_DESKTOP",
+    "_NET_CURRENT_DESKTOP",
+    "_NET_WM_MOVERESIZE",
+    "_NET_SUPPORTED",
+    "_NET_SUPPORTING_WM_CHECK",
+    "_GTK_FRAME_EXTENTS",
+    "_NET_WM_OPAQUE_REGION",
+    "_NET_WM_BYPASS_COMPOSITOR",
+    "WM_PROTOCOLS",
+    "_NET_WM_SYNC_REQUEST",
+    "_NET_WM_SYNC_REQUEST_COUNTER",
+    "_NET_WM_FRAME_DRAWN",
+    "_NET_WM_FRAME_TIMINGS",
+};
+static_assert(std::size(kAtomNames) ==
+              static_cast<std::size_t>(X11Atom::Count));
+
+X11Atoms &X11Atoms::instance() {
+    static auto atoms = X11Atoms();
+    return atoms;
+}
+
+void X11Atoms::prefetch() {
+    if (this->m_requested || !QX11Info::isPlatformX11()) {
+        return;
+    }
+    this->m_requested = true;
+    auto *connection = QX11Info::connection();
+    for (std::size_t i = 0; i < kCount; ++i) {
+        this->m_cookies[i] = xcb_intern_atom(
+            connection,
+            false,
+            static_cast<std::uint16_t>(std::strlen(kAtomNames[i])),
+            kAtomNames[i]);
+    }
+}
+
+xcb_atom_t X11Atoms::atom(X11Atom atom) {
+    if (!this->m_resolved) {
+        this->prefetch();
+        if (!this->m_requested) {
+            return XCB_ATOM_NONE;
+        }
+        this->m_resolved = true;
+        auto *connection = QX11Info::connection();
+        countX11RoundTrip();
+        for (std::size_t i = 0; i < kCount; ++i) {
+            auto *reply =
+                xcb_intern_atom_reply(connection, this->m_cookies[i], nullptr);
+            if (reply != nullptr) {
+                this->m_atoms[i] = reply->atom;
+            }
+            std::free(reply);
+        }
+    }
+    return this->m_atoms[static_cast<std::size_t>(atom)];
+}
+
+void countX11RoundTrip() {
+    ++s_x11RoundTrips;
+}
+
+quint64 x11RoundTrips() {
+    return s_x11RoundTrips;
+}
+
+} // namespace CSD::Internal
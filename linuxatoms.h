@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <xcb/xcb.h>
+
+#include <array>
+#include <cstddef>
+
+namespace CSD::Internal {
+
+enum class X11Atom : std::size_t {
+    NetWmState,
+    NetWmStateHidden,
+    NetWmStateMaximizedVert,
+    NetWmStateMaximizedHorz,
+    NetWmStateFullscreen,
+    NetWmDesktop,
+    NetCurrentDesktop,
+    NetWmMoveResize,
+    NetSupported,
+    NetSupportingWmCheck,
+    GtkFrameExtents,
+    NetWmOpaqueRegion,
+    NetWmBypassCompositor,
+    WmProtocols,
+    NetWmSyncRequest,
+    NetWmSyncRequestCounter,
+    NetWmFrameDrawn,
+    NetWmFrameTimings,
+    Count,
+};
+
+// The EWMH atoms used by the decorations, interned in one batch. prefetch()
+// only sends the requests; their replies are collected together on the first
+// lookup, so the whole batch costs a single round trip.
+class X11Atoms {
+public:
+    static X11Atoms &instance();
+
+    void prefetch();
+    xcb_atom_t atom(X11Atom atom);
+
+private:
+    X11Atoms() = default;
+
+    static constexpr auto kCount = static_cast<std::size_t>(X11Atom::Count);
+
+    std::array<xcb_intern_atom_cookie_t, kCount> m_cookies = {};
+    std::array<xcb_atom_t, kCount> m_atoms = {};
+    bool m_requested = false;
+    bool m_resolved = false;
+};
+
+// Blocking requests to the X server made by the decorations, so hot paths
+// can check they do not wait on the server.
+void countX11RoundTrip();
+quint64 x11RoundTrips();
+
+} // namespace CSD::Internal
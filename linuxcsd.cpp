@@ -1,48 +1,1084 @@
 #include "linuxcsd.h"
 
+#include "csdresizeedges.h"
+#include "csdsystemmove.h"
+#include "csdwindowshadow.h"
+#include "linuxatoms.h"
+#include "linuxmoveresize.h"
+
 #include <QEvent>
+#include <QGuiApplication>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPointer>
 #include <QWidget>
+#include <QWindow>
+
+#include <QX11Info>
+
+#include <private/qhighdpiscaling_p.h>
+#include <qpa/qplatformscreen.h>
+#include <qpa/qplatformwindow.h>
+
+#include <xcb/shape.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
 
 namespace CSD::Internal {
 
+constexpr static quint32 kAllDesktops = 0xFFFFFFFF;
+
+static quint64 s_lastSystemMoveRoundTrips = 0;
+
+static xcb_atom_t atom(X11Atom atom) {
+    return X11Atoms::instance().atom(atom);
+}
+
+static QWidget *titleBarTopLevelWidget(QWidget *w) {
+    while (w && !w->isWindow() && w->windowType() != Qt::SubWindow) {
+        w = w->parentWidget();
+    }
+    return w;
+}
+
+// length counts 32-bit units.
+static xcb_get_property_reply_t *getProperty(xcb_window_t window,
+                                             xcb_atom_t property,
+                                             xcb_atom_t type,
+                                             std::uint32_t length = 32) {
+    auto *connection = QX11Info::connection();
+    const auto cookie = xcb_get_property(
+        connection, false, window, property, type, 0, length);
+    countX11RoundTrip();
+    return xcb_get_property_reply(connection, cookie, nullptr);
+}
+
+static quint32 readValue(xcb_window_t window,
+                         xcb_atom_t property,
+                         xcb_atom_t type,
+                         quint32 fallback) {
+    auto *reply = getProperty(window, property, type);
+    auto value = fallback;
+    if (reply != nullptr && reply->format == 32 &&
+        xcb_get_property_value_length(reply) >= 4) {
+        std::memcpy(&value, xcb_get_property_value(reply), sizeof(value));
+    }
+    std::free(reply);
+    return value;
+}
+
+static quint32
+readCardinal(xcb_window_t window, xcb_atom_t property, quint32 fallback) {
+    return readValue(window, property, XCB_ATOM_CARDINAL, fallback);
+}
+
+static bool hasAtom(xcb_window_t window,
+                    xcb_atom_t property,
+                    xcb_atom_t atom,
+                    std::uint32_t length = 32) {
+    auto *reply = getProperty(window, property, XCB_ATOM_ATOM, length);
+    bool found = false;
+    if (reply != nullptr && reply->format == 32) {
+        const auto *atoms =
+            static_cast<const xcb_atom_t *>(xcb_get_property_value(reply));
+        const auto count = xcb_get_property_value_length(reply) / 4;
+        found = std::find(atoms, atoms + count, atom) != atoms + count;
+    }
+    std::free(reply);
+    return found;
+}
+
+// The window states _NET_WM_STATE of window holds.
+static Qt::WindowStates readWindowState(xcb_window_t window) {
+    auto *reply =
+        getProperty(window, atom(X11Atom::NetWmState), XCB_ATOM_ATOM);
+    auto states = Qt::WindowStates();
+    if (reply != nullptr && reply->format == 32) {
+        const auto *atoms =
+            static_cast<const xcb_atom_t *>(xcb_get_property_value(reply));
+        const auto count = xcb_get_property_value_length(reply) / 4;
+        bool maximizedVert = false;
+        bool maximizedHorz = false;
+        for (int i = 0; i < count; ++i) {
+            if (atoms[i] == atom(X11Atom::NetWmStateHidden)) {
+                states |= Qt::WindowMinimized;
+            } else if (atoms[i] == atom(X11Atom::NetWmStateFullscreen)) {
+                states |= Qt::WindowFullScreen;
+            } else if (atoms[i] == atom(X11Atom::NetWmStateMaximizedVert)) {
+                maximizedVert = true;
+            } else if (atoms[i] == atom(X11Atom::NetWmStateMaximizedHorz)) {
+                maximizedHorz = true;
+            }
+        }
+        states.setFlag(Qt::WindowMaximized, maximizedVert && maximizedHorz);
+    }
+    std::free(reply);
+    return states;
+}
+
+constexpr static Qt::WindowStates kTrackedWindowStates =
+    Qt::WindowMinimized | Qt::WindowMaximized | Qt::WindowFullScreen;
+
+// Whether a running EWMH window manager handles _NET_WM_MOVERESIZE; checked
+// when the decorations start and when the window manager changes.
+static std::optional<bool> s_windowManagerMovesWindows;
+
+static void detectWindowManager() {
+    const auto root = static_cast<xcb_window_t>(QX11Info::appRootWindow());
+    const auto check = readValue(
+        root, atom(X11Atom::NetSupportingWmCheck), XCB_ATOM_WINDOW, XCB_NONE);
+    // A window manager that went away leaves a stale property on the root
+    // window, its check window is gone and does not point to itself.
+    const bool running =
+        check != XCB_NONE && readValue(check,
+                                       atom(X11Atom::NetSupportingWmCheck),
+                                       XCB_ATOM_WINDOW,
+                                       XCB_NONE) == check;
+    // _NET_SUPPORTED lists a few hundred atoms in common window managers.
+    s_windowManagerMovesWindows =
+        running && hasAtom(root,
+                           atom(X11Atom::NetSupported),
+                           atom(X11Atom::NetWmMoveResize),
+                           1024);
+}
+
+// Tells a decorated widget's events where its callbacks are, without a
+// search. The widget owns it.
+struct LinuxClientSideDecorationFilter::WidgetData : QObjectUserData {
+    const LinuxClientSideDecorationFilter *filter = nullptr;
+    WidgetCallbacks *callbacks = nullptr;
+};
+
+static uint widgetDataId() {
+    static const uint id = QObject::registerUserData();
+    return id;
+}
+
+void LinuxClientSideDecorationFilter::releaseWidgetData(
+    QObject *object) const {
+    auto *data = static_cast<WidgetData *>(object->userData(widgetDataId()));
+    if (data != nullptr && data->filter == this) {
+        delete data;
+        object->setUserData(widgetDataId(), nullptr);
+    }
+}
+
 LinuxClientSideDecorationFilter::WidgetCallbacks::WidgetCallbacks(
-    Callback onActivationChanged, Callback onWindowStateChanged)
-    : onActivationChanged(std::move(onActivationChanged)),
+    VisibilityCallback onVisibilityChanged,
+    ActivationCallback onActivationChanged,
+    WindowStateCallback onWindowStateChanged)
+    : onVisibilityChanged(std::move(onVisibilityChanged)),
+      onActivationChanged(std::move(onActivationChanged)),
       onWindowStateChanged(std::move(onWindowStateChanged)) {}
 
 LinuxClientSideDecorationFilter::LinuxClientSideDecorationFilter(
     QObject *parent)
-    : QObject(parent) {}
+    : QObject(parent) {
+    if (!QX11Info::isPlatformX11()) {
+        return;
+    }
+    // Sent now, the replies are read together with the first property.
+    X11Atoms::instance().prefetch();
+    this->m_currentDesktop = readCardinal(
+        static_cast<xcb_window_t>(QX11Info::appRootWindow()),
+        atom(X11Atom::NetCurrentDesktop),
+        0);
+    detectWindowManager();
+}
 
 LinuxClientSideDecorationFilter::~LinuxClientSideDecorationFilter() {
+    this->setResizeCursor(Qt::Edges());
     for (const auto &pair : this->m_callbacks) {
         pair.first->removeEventFilter(this);
+        if (pair.second->windowHandle != nullptr) {
+            pair.second->windowHandle->removeEventFilter(this);
+        }
+        this->releaseWidgetData(pair.first);
+    }
+}
+
+// The first element of pairs, sorted by their first member, whose first
+// member is not less than key.
+template <typename Pairs, typename Key>
+static auto lowerBound(Pairs &pairs, Key *key) {
+    return std::lower_bound(
+        pairs.begin(), pairs.end(), key, [](const auto &pair, Key *rhs) {
+            return std::less<const void *>()(pair.first, rhs);
+        });
+}
+
+// Whether the widget filter acts on event, decided without looking up the
+// widget. Decorated windows get plenty of events it ignores, and with an
+// application filter so does every other widget.
+static bool isWidgetEventFiltered(const QObject *watched, QEvent::Type type) {
+    if (!watched->isWidgetType() ||
+        !static_cast<const QWidget *>(watched)->isWindow()) {
+        return false;
+    }
+    switch (type) {
+    case QEvent::ActivationChange:
+    case QEvent::WindowStateChange:
+    case QEvent::Show:
+    case QEvent::Hide:
+    case QEvent::WinIdChange:
+    case QEvent::Resize:
+    case QEvent::UpdateRequest:
+        return true;
+    case QEvent::Paint:
+        // Only windows with a shadow paint, setShadow() made them
+        // translucent.
+        return static_cast<const QWidget *>(watched)->testAttribute(
+            Qt::WA_TranslucentBackground);
+    default:
+        return false;
     }
 }
 
 bool LinuxClientSideDecorationFilter::eventFilter(QObject *watched,
                                                   QEvent *event) {
+    if (watched->isWindowType()) {
+        return this->windowEventFilter(static_cast<QWindow *>(watched),
+                                       event);
+    }
+    if (!isWidgetEventFiltered(watched, event->type())) {
+        return false;
+    }
     QWidget *widget = static_cast<QWidget *>(watched);
-    auto resultIterator = this->m_callbacks.find(widget);
+    auto *found = this->callbacksForWidget(widget);
+    if (found == nullptr) {
+        return false;
+    }
+    auto &callbacks = *found;
 
-    if (event->type() == QEvent::ActivationChange) {
-        resultIterator->second.onActivationChanged();
-    } else if (event->type() == QEvent::WindowStateChange) {
-        resultIterator->second.onWindowStateChanged();
+    // On X11 the X events tell about changes made by the window manager
+    // first, only changes the application makes are taken from Qt.
+    const bool fromX11 = QX11Info::isPlatformX11();
+    switch (event->type()) {
+    case QEvent::ActivationChange:
+        if (!fromX11) {
+            this->setActive(callbacks, widget->isActiveWindow());
+        }
+        break;
+    case QEvent::WindowStateChange:
+        if (!fromX11 || !event->spontaneous()) {
+            this->setWindowState(widget, callbacks, widget->windowState());
+        }
+        break;
+    case QEvent::Show:
+        if (callbacks.windowHandle == nullptr) {
+            this->registerWindow(widget, callbacks);
+        }
+        this->updateShadow(widget, callbacks);
+        updateCompositorHints(widget, callbacks);
+        break;
+    case QEvent::WinIdChange:
+        // setParent() and setWindowFlags() among others replace the window,
+        // and with it what was set up for the old one.
+        this->forgetWindow(callbacks);
+        if (widget->isVisible() && widget->internalWinId() != 0) {
+            this->registerWindow(widget, callbacks);
+        }
+        break;
+    case QEvent::Resize:
+        if (callbacks.shadow.margin > 0) {
+            updateShadowRegions(widget, callbacks.shadow);
+        }
+        updateCompositorHints(widget, callbacks);
+        updateHitTestFrame(widget, callbacks);
+        break;
+    case QEvent::UpdateRequest:
+        if (callbacks.frameSync != nullptr) {
+            this->bracketFrame(widget, *callbacks.frameSync);
+        }
+        break;
+    case QEvent::Paint:
+        // Goes below whatever the window paints itself.
+        if (callbacks.shadow.radius > 0) {
+            paintShadow(widget, callbacks.shadow);
+        }
+        break;
+    case QEvent::Hide:
+        callbacks.visibility.mapped = false;
+        this->updateVisibility(widget, callbacks);
+        break;
+    default:
+        break;
     }
 
     return false;
 }
 
+bool LinuxClientSideDecorationFilter::nativeEventFilter(
+    const QByteArray &eventType,
+    void *message,
+    [[maybe_unused]] long *result) {
+    if (eventType != "xcb_generic_event_t" || this->m_callbacks.empty()) {
+        return false;
+    }
+    auto *event = static_cast<xcb_generic_event_t *>(message);
+    QWidget *widget = nullptr;
+    switch (event->response_type & ~0x80) {
+    case XCB_MAP_NOTIFY: {
+        auto *mapNotify = reinterpret_cast<xcb_map_notify_event_t *>(event);
+        auto *callbacks = this->callbacksForWindow(mapNotify->window, &widget);
+        if (callbacks != nullptr) {
+            callbacks->visibility.mapped = true;
+            this->updateVisibility(widget, *callbacks);
+        }
+        break;
+    }
+    case XCB_UNMAP_NOTIFY: {
+        auto *unmapNotify =
+            reinterpret_cast<xcb_unmap_notify_event_t *>(event);
+        auto *callbacks =
+            this->callbacksForWindow(unmapNotify->window, &widget);
+        if (callbacks != nullptr) {
+            callbacks->visibility.mapped = false;
+            this->updateVisibility(widget, *callbacks);
+        }
+        break;
+    }
+    case XCB_VISIBILITY_NOTIFY: {
+        auto *visibilityNotify =
+            reinterpret_cast<xcb_visibility_notify_event_t *>(event);
+        auto *callbacks =
+            this->callbacksForWindow(visibilityNotify->window, &widget);
+        if (callbacks != nullptr) {
+            callbacks->visibility.obscured =
+                visibilityNotify->state == XCB_VISIBILITY_FULLY_OBSCURED;
+            this->updateVisibility(widget, *callbacks);
+        }
+        break;
+    }
+    case XCB_FOCUS_IN:
+    case XCB_FOCUS_OUT: {
+        auto *focus = reinterpret_cast<xcb_focus_in_event_t *>(event);
+        // Keyboard grabs, such as the window manager's while switching
+        // windows, and focus moving within the window change nothing.
+        if (focus->mode == XCB_NOTIFY_MODE_GRAB ||
+            focus->mode == XCB_NOTIFY_MODE_UNGRAB ||
+            focus->detail == XCB_NOTIFY_DETAIL_POINTER ||
+            focus->detail == XCB_NOTIFY_DETAIL_INFERIOR) {
+            break;
+        }
+        auto *callbacks = this->callbacksForWindow(focus->event, &widget);
+        if (callbacks != nullptr) {
+            this->setActive(*callbacks,
+                            (event->response_type & ~0x80) == XCB_FOCUS_IN);
+        }
+        break;
+    }
+    case XCB_CLIENT_MESSAGE: {
+        auto *clientMessage =
+            reinterpret_cast<xcb_client_message_event_t *>(event);
+        auto *callbacks =
+            this->callbacksForWindow(clientMessage->window, &widget);
+        if (callbacks == nullptr || callbacks->frameSync == nullptr) {
+            break;
+        }
+        auto &frameSync = *callbacks->frameSync;
+        if (clientMessage->type == atom(X11Atom::WmProtocols) &&
+            clientMessage->data.data32[0] ==
+                atom(X11Atom::NetWmSyncRequest)) {
+            // Qt still sees the request and answers its basic counter.
+            frameSync.syncRequested(clientMessage);
+        } else if (clientMessage->type == atom(X11Atom::NetWmFrameDrawn)) {
+            frameSync.frameDrawn(clientMessage);
+        } else if (clientMessage->type == atom(X11Atom::NetWmFrameTimings)) {
+            frameSync.frameTimings(clientMessage);
+        }
+        break;
+    }
+    case XCB_PROPERTY_NOTIFY: {
+        auto *propertyNotify =
+            reinterpret_cast<xcb_property_notify_event_t *>(event);
+        if ((propertyNotify->atom == atom(X11Atom::NetSupportingWmCheck) ||
+             propertyNotify->atom == atom(X11Atom::NetSupported)) &&
+            propertyNotify->window == QX11Info::appRootWindow()) {
+            detectWindowManager();
+            break;
+        }
+        if (propertyNotify->atom == atom(X11Atom::NetCurrentDesktop) &&
+            propertyNotify->window == QX11Info::appRootWindow()) {
+            this->m_currentDesktop =
+                readCardinal(propertyNotify->window, propertyNotify->atom, 0);
+            for (auto &pair : this->m_callbacks) {
+                this->updateVisibility(pair.first, *pair.second);
+            }
+            break;
+        }
+        if (propertyNotify->atom != atom(X11Atom::NetWmState) &&
+            propertyNotify->atom != atom(X11Atom::NetWmDesktop)) {
+            break;
+        }
+        auto *callbacks =
+            this->callbacksForWindow(propertyNotify->window, &widget);
+        if (callbacks == nullptr) {
+            break;
+        }
+        if (propertyNotify->atom == atom(X11Atom::NetWmState)) {
+            const auto windowState = readWindowState(propertyNotify->window);
+            callbacks->visibility.hidden =
+                windowState.testFlag(Qt::WindowMinimized);
+            this->setWindowState(widget, *callbacks, windowState);
+        } else {
+            callbacks->visibility.desktop =
+                readCardinal(propertyNotify->window,
+                             atom(X11Atom::NetWmDesktop),
+                             kAllDesktops);
+        }
+        this->updateVisibility(widget, *callbacks);
+        break;
+    }
+    default:
+        break;
+    }
+    return false;
+}
+
+void LinuxClientSideDecorationFilter::apply(
+    QWidget *widget,
+    VisibilityCallback onVisibilityChanged,
+    ActivationCallback onActivationChanged,
+    WindowStateCallback onWindowStateChanged) {
+    this->registerWidget(
+        widget,
+        std::make_unique<WidgetCallbacks>(std::move(onVisibilityChanged),
+                                          std::move(onActivationChanged),
+                                          std::move(onWindowStateChanged)));
+}
+
 void LinuxClientSideDecorationFilter::apply(QWidget *widget,
-                                            Callback onActivationChanged,
-                                            Callback onWindowStateChanged) {
+                                            TitleBarClient *titleBar) {
+    if (this->callbacksForWidget(widget) != nullptr) {
+        return;
+    }
+    auto callbacks = std::make_unique<WidgetCallbacks>();
+    callbacks->titleBar = titleBar;
+    titleBar->setHitTestMap(&callbacks->hitTestMap);
+    this->registerWidget(widget, std::move(callbacks));
+}
+
+void LinuxClientSideDecorationFilter::setFiltersApplication(bool on) {
+    this->m_filtersApplication = on;
+}
+
+void LinuxClientSideDecorationFilter::registerWidget(
+    QWidget *widget, std::unique_ptr<WidgetCallbacks> callbacks) {
+    if (this->callbacksForWidget(widget) != nullptr) {
+        return;
+    }
+    callbacks->active = widget->isActiveWindow();
+    callbacks->windowState = widget->windowState() & kTrackedWindowStates;
+    // A widget some other filter decorated keeps that filter's data, this
+    // one then falls back to searching m_callbacks.
+    if (widget->userData(widgetDataId()) == nullptr) {
+        auto *data = new WidgetData();
+        data->filter = this;
+        data->callbacks = callbacks.get();
+        widget->setUserData(widgetDataId(), data);
+    }
     this->m_callbacks.emplace(
-        widget,
-        WidgetCallbacks(std::move(onActivationChanged),
-                        std::move(onWindowStateChanged)));
-    widget->installEventFilter(this);
+        lowerBound(this->m_callbacks, widget), widget, std::move(callbacks));
+    if (!this->m_filtersApplication) {
+        widget->installEventFilter(this);
+    }
     widget->setWindowFlag(Qt::FramelessWindowHint);
+    connect(widget,
+            &QObject::destroyed,
+            this,
+            &LinuxClientSideDecorationFilter::unregisterWidget);
+}
+
+void LinuxClientSideDecorationFilter::unregisterWidget(QObject *object) {
+    // Only the address is left of the widget by now.
+    const auto found = lowerBound(this->m_callbacks, object);
+    if (found == this->m_callbacks.end() ||
+        static_cast<QObject *>(found->first) != object) {
+        return;
+    }
+    // Its QObject part still holds the user data, which would otherwise
+    // outlive the callbacks until the widget's destructor finishes.
+    this->releaseWidgetData(object);
+    this->forgetWindow(*found->second);
+    this->m_callbacks.erase(found);
+}
+
+void LinuxClientSideDecorationFilter::registerWindow(
+    QWidget *widget, WidgetCallbacks &callbacks) {
+    this->selectVisibilityEvents(widget, callbacks.visibility);
+    callbacks.window = static_cast<xcb_window_t>(widget->internalWinId());
+    if (callbacks.window != XCB_NONE) {
+        this->m_windows.insert(callbacks.window, widget);
+    }
+    // The window sees mouse events before any child widget does, so the
+    // resize border works above the window's content.
+    callbacks.windowHandle = widget->windowHandle();
+    this->m_windowHandles.emplace(
+        lowerBound(this->m_windowHandles, callbacks.windowHandle),
+        callbacks.windowHandle,
+        widget);
+    if (moveResizeBackend() != MoveResizeBackend::None &&
+        !this->m_filtersApplication) {
+        callbacks.windowHandle->installEventFilter(this);
+    }
+    this->setUpFrameSync(widget, callbacks);
+    // A replaced window starts without the shadow's extents and input shape.
+    if (callbacks.shadow.margin > 0) {
+        updateShadowRegions(widget, callbacks.shadow);
+    }
+}
+
+void LinuxClientSideDecorationFilter::forgetWindow(
+    WidgetCallbacks &callbacks) {
+    if (callbacks.window != XCB_NONE) {
+        this->m_windows.remove(callbacks.window);
+        callbacks.window = XCB_NONE;
+    }
+    // The window handle may be gone already, only its address is used.
+    if (callbacks.windowHandle != nullptr) {
+        const auto found =
+            lowerBound(this->m_windowHandles, callbacks.windowHandle);
+        if (found != this->m_windowHandles.end() &&
+            found->first == callbacks.windowHandle) {
+            this->m_windowHandles.erase(found);
+        }
+        callbacks.windowHandle = nullptr;
+    }
+    callbacks.frameSync.reset();
+    callbacks.compositorHints = CompositorHints();
+}
+
+std::vector<FrameTiming>
+LinuxClientSideDecorationFilter::frameTimings(QWidget *widget) const {
+    const auto *callbacks = this->callbacksForWidget(widget);
+    if (callbacks == nullptr || callbacks->frameSync == nullptr) {
+        return {};
+    }
+    return callbacks->frameSync->timings();
+}
+
+void LinuxClientSideDecorationFilter::setUpFrameSync(
+    QWidget *widget, WidgetCallbacks &callbacks) {
+    if (!QX11Info::isPlatformX11()) {
+        return;
+    }
+    // Qt puts its basic counter into the property when it creates the
+    // window; the extended counter goes next to it.
+    const auto window = static_cast<xcb_window_t>(widget->winId());
+    const auto basicCounter = readValue(window,
+                                        atom(X11Atom::NetWmSyncRequestCounter),
+                                        XCB_ATOM_CARDINAL,
+                                        XCB_NONE);
+    auto frameSync = std::make_unique<FrameSync>(window, basicCounter);
+    if (frameSync->isValid()) {
+        callbacks.frameSync = std::move(frameSync);
+    }
+}
+
+void LinuxClientSideDecorationFilter::setShadow(QWidget *widget,
+                                                int radius,
+                                                const QColor &color) {
+    auto *callbacks = this->callbacksForWidget(widget);
+    if (callbacks == nullptr) {
+        return;
+    }
+    auto &shadow = callbacks->shadow;
+    shadow.radius = qMax(0, radius);
+    shadow.color = color;
+    widget->setAttribute(Qt::WA_TranslucentBackground);
+    if (widget->isVisible()) {
+        this->updateShadow(widget, *callbacks);
+    }
+}
+
+void LinuxClientSideDecorationFilter::updateShadow(
+    QWidget *widget, WidgetCallbacks &callbacks) {
+    auto &shadow = callbacks.shadow;
+    const bool drawn = shadow.radius > 0 &&
+                       QX11Info::isCompositingManagerRunning() &&
+                       !(callbacks.windowState &
+                         (Qt::WindowMaximized | Qt::WindowFullScreen));
+    const auto margin = drawn ? shadow.radius : 0;
+    if (margin == shadow.margin) {
+        return;
+    }
+    // Only the shadow's share changes; margins set by the application or
+    // taken by the DecorationManager's title bar stay as they are.
+    const auto delta = margin - shadow.margin;
+    shadow.margin = margin;
+    widget->setContentsMargins(widget->contentsMargins() +
+                               QMargins(delta, delta, delta, delta));
+    updateShadowRegions(widget, shadow);
+    updateCompositorHints(widget, callbacks);
+    updateHitTestFrame(widget, callbacks);
+    widget->update();
+}
+
+void LinuxClientSideDecorationFilter::updateHitTestFrame(
+    QWidget *widget, WidgetCallbacks &callbacks) {
+    const bool resizable = !(callbacks.windowState &
+                             (Qt::WindowMaximized | Qt::WindowFullScreen));
+    // With a shadow, the border is the band of it next to the content.
+    callbacks.hitTestMap.setFrame(
+        widget->size(),
+        qMax(0, callbacks.shadow.margin - kResizeBorderWidth),
+        resizable && widget->minimumWidth() != widget->maximumWidth(),
+        resizable && widget->minimumHeight() != widget->maximumHeight());
+}
+
+void LinuxClientSideDecorationFilter::updateCompositorHints(
+    QWidget *widget, WidgetCallbacks &callbacks) {
+    if (!QX11Info::isPlatformX11() || widget->internalWinId() == 0) {
+        return;
+    }
+    // The content is opaque unless the palette lets the windows below
+    // show through; the shadow around it never is.
+    const auto dpr = widget->devicePixelRatioF();
+    auto opaqueRegion = QRect();
+    if (widget->palette().window().isOpaque()) {
+        const auto margin = callbacks.shadow.margin;
+        const auto content = widget->rect().marginsRemoved(
+            QMargins(margin, margin, margin, margin));
+        opaqueRegion = QRect(qRound(content.x() * dpr),
+                             qRound(content.y() * dpr),
+                             qRound(content.width() * dpr),
+                             qRound(content.height() * dpr));
+    }
+    // Full screen content covers the output, the compositor may hand it
+    // the screen directly.
+    const bool bypass = callbacks.windowState.testFlag(Qt::WindowFullScreen);
+
+    auto &hints = callbacks.compositorHints;
+    if (hints.set && hints.opaqueRegion == opaqueRegion &&
+        hints.bypass == bypass) {
+        return;
+    }
+    auto *connection = QX11Info::connection();
+    const auto window = static_cast<xcb_window_t>(widget->internalWinId());
+    if (!hints.set || hints.opaqueRegion != opaqueRegion) {
+        if (opaqueRegion.isEmpty()) {
+            xcb_delete_property(
+                connection, window, atom(X11Atom::NetWmOpaqueRegion));
+        } else {
+            const quint32 rectangle[] = {
+                static_cast<quint32>(opaqueRegion.x()),
+                static_cast<quint32>(opaqueRegion.y()),
+                static_cast<quint32>(opaqueRegion.width()),
+                static_cast<quint32>(opaqueRegion.height())};
+            xcb_change_property(connection,
+                                XCB_PROP_MODE_REPLACE,
+                                window,
+                                atom(X11Atom::NetWmOpaqueRegion),
+                                XCB_ATOM_CARDINAL,
+                                32,
+                                4,
+                                rectangle);
+        }
+    }
+    if (!hints.set || hints.bypass != bypass) {
+        if (bypass) {
+            const quint32 value = 1;
+            xcb_change_property(connection,
+                                XCB_PROP_MODE_REPLACE,
+                                window,
+                                atom(X11Atom::NetWmBypassCompositor),
+                                XCB_ATOM_CARDINAL,
+                                32,
+                                1,
+                                &value);
+        } else {
+            xcb_delete_property(
+                connection, window, atom(X11Atom::NetWmBypassCompositor));
+        }
+    }
+    hints = CompositorHints{opaqueRegion, bypass, true};
+}
+
+void LinuxClientSideDecorationFilter::paintShadow(QWidget *widget,
+                                                  const WindowShadow &shadow) {
+    // The window is translucent, its content needs a background of its own.
+    auto painter = QPainter(widget);
+    const auto margin = shadow.margin;
+    if (margin == 0) {
+        painter.fillRect(widget->rect(), widget->palette().window());
+        return;
+    }
+    WindowShadowCache::instance().paint(
+        painter, widget->rect(), margin, shadow.color);
+    const auto margins = QMargins(margin, margin, margin, margin);
+    painter.fillRect(widget->rect().marginsRemoved(margins),
+                     widget->palette().window());
+}
+
+void LinuxClientSideDecorationFilter::updateShadowRegions(
+    QWidget *widget, const WindowShadow &shadow) {
+    if (!QX11Info::isPlatformX11() || widget->internalWinId() == 0) {
+        return;
+    }
+    auto *connection = QX11Info::connection();
+    const auto window = static_cast<xcb_window_t>(widget->internalWinId());
+    if (shadow.margin == 0) {
+        xcb_delete_property(
+            connection, window, atom(X11Atom::GtkFrameExtents));
+        xcb_shape_mask(connection,
+                       XCB_SHAPE_SO_SET,
+                       XCB_SHAPE_SK_INPUT,
+                       window,
+                       0,
+                       0,
+                       XCB_NONE);
+        return;
+    }
+
+    // Both are in device pixels. The extents tell the window manager and the
+    // compositor where the visible frame is.
+    const auto dpr = widget->devicePixelRatioF();
+    const auto extent = static_cast<quint32>(qRound(shadow.margin * dpr));
+    const quint32 extents[] = {extent, extent, extent, extent};
+    xcb_change_property(connection,
+                        XCB_PROP_MODE_REPLACE,
+                        window,
+                        atom(X11Atom::GtkFrameExtents),
+                        XCB_ATOM_CARDINAL,
+                        32,
+                        4,
+                        extents);
+
+    // Clicks on the shadow go to the windows below, except on the resize
+    // border next to the content.
+    const auto inset = qRound(
+        qMax(0, shadow.margin - kResizeBorderWidth) * dpr);
+    const auto width = qMax(0, qRound(widget->width() * dpr) - 2 * inset);
+    const auto height = qMax(0, qRound(widget->height() * dpr) - 2 * inset);
+    const auto input =
+        xcb_rectangle_t{static_cast<std::int16_t>(inset),
+                        static_cast<std::int16_t>(inset),
+                        static_cast<std::uint16_t>(width),
+                        static_cast<std::uint16_t>(height)};
+    xcb_shape_rectangles(connection,
+                         XCB_SHAPE_SO_SET,
+                         XCB_SHAPE_SK_INPUT,
+                         XCB_CLIP_ORDERING_UNSORTED,
+                         window,
+                         0,
+                         0,
+                         1,
+                         &input);
+}
+
+void LinuxClientSideDecorationFilter::bracketFrame(QWidget *widget,
+                                                   FrameSync &frameSync) {
+    if (frameSync.isInFrame()) {
+        return;
+    }
+    frameSync.beginFrame();
+    // Runs once the event that started the frame has been delivered, and
+    // with it the repaint and the flush to the X server. Update requests
+    // are posted at low priority, so the next one comes after this.
+    QMetaObject::invokeMethod(
+        this,
+        [this, window = QPointer<QWidget>(widget)] {
+            auto *callbacks =
+                window != nullptr ? this->callbacksForWidget(window) : nullptr;
+            if (callbacks != nullptr && callbacks->frameSync != nullptr) {
+                callbacks->frameSync->endFrame();
+            }
+        },
+        Qt::QueuedConnection);
+}
+
+bool LinuxClientSideDecorationFilter::windowEventFilter(QWindow *window,
+                                                        QEvent *event) {
+    const auto type = event->type();
+    if (type == QEvent::Leave) {
+        this->setResizeCursor(Qt::Edges());
+        return false;
+    }
+    if (type != QEvent::MouseMove && type != QEvent::MouseButtonPress &&
+        type != QEvent::Expose) {
+        return false;
+    }
+    QWidget *widget = nullptr;
+    auto *callbacks = this->callbacksForWindowHandle(window, &widget);
+    if (callbacks == nullptr) {
+        return false;
+    }
+    if (type == QEvent::Expose) {
+        // Widgets repaint exposed areas right away, which is how resizes
+        // get painted.
+        if (callbacks->frameSync != nullptr) {
+            this->bracketFrame(widget, *callbacks->frameSync);
+        }
+        return false;
+    }
+    auto *mouseEvent = static_cast<QMouseEvent *>(event);
+    const auto edges = callbacks->hitTestMap.hitTest(mouseEvent->pos()).edges;
+
+    if (type == QEvent::MouseMove) {
+        // While a button is held the cursor belongs to whatever got the
+        // press.
+        if (mouseEvent->buttons() == Qt::NoButton) {
+            this->setResizeCursor(edges);
+        }
+        return false;
+    }
+    if (!edges || mouseEvent->button() != Qt::LeftButton) {
+        return false;
+    }
+    return startWindowResize(widget, mouseEvent->pos(), edges);
+}
+
+void LinuxClientSideDecorationFilter::setResizeCursor(Qt::Edges edges) {
+    if (edges == this->m_cursorEdges) {
+        return;
+    }
+    if (!edges) {
+        QGuiApplication::restoreOverrideCursor();
+    } else if (!this->m_cursorEdges) {
+        QGuiApplication::setOverrideCursor(resizeCursor(edges));
+    } else {
+        QGuiApplication::changeOverrideCursor(resizeCursor(edges));
+    }
+    this->m_cursorEdges = edges;
+}
+
+void LinuxClientSideDecorationFilter::selectVisibilityEvents(
+    QWidget *widget, WindowVisibility &visibility) {
+    if (!QX11Info::isPlatformX11()) {
+        return;
+    }
+    // Qt does not ask for VisibilityNotify, add it to the mask Qt selected.
+    auto *connection = QX11Info::connection();
+    const auto window = static_cast<xcb_window_t>(widget->winId());
+    const auto cookie = xcb_get_window_attributes(connection, window);
+    countX11RoundTrip();
+    auto *reply = xcb_get_window_attributes_reply(connection, cookie, nullptr);
+    if (reply != nullptr) {
+        const std::uint32_t eventMask = reply->your_event_mask |
+                                        XCB_EVENT_MASK_VISIBILITY_CHANGE |
+                                        XCB_EVENT_MASK_STRUCTURE_NOTIFY |
+                                        XCB_EVENT_MASK_PROPERTY_CHANGE;
+        xcb_change_window_attributes(
+            connection, window, XCB_CW_EVENT_MASK, &eventMask);
+    }
+    std::free(reply);
+    visibility.hidden =
+        readWindowState(window).testFlag(Qt::WindowMinimized);
+    visibility.desktop =
+        readCardinal(window, atom(X11Atom::NetWmDesktop), kAllDesktops);
+}
+
+void LinuxClientSideDecorationFilter::updateVisibility(
+    QWidget *widget, WidgetCallbacks &callbacks) {
+    auto &visibility = callbacks.visibility;
+    const bool onCurrentDesktop = visibility.desktop == kAllDesktops ||
+                                  visibility.desktop == this->m_currentDesktop;
+    const bool visible = visibility.mapped && !visibility.obscured &&
+                         !visibility.hidden && onCurrentDesktop &&
+                         !(callbacks.windowState & Qt::WindowMinimized);
+    if (visible == visibility.visible) {
+        return;
+    }
+    visibility.visible = visible;
+    if (callbacks.titleBar != nullptr) {
+        callbacks.titleBar->setVisibleOnScreen(visible);
+    } else {
+        callbacks.onVisibilityChanged(visible);
+    }
+}
+
+void LinuxClientSideDecorationFilter::setActive(WidgetCallbacks &callbacks,
+                                                bool active) {
+    if (active == callbacks.active) {
+        return;
+    }
+    callbacks.active = active;
+    if (callbacks.titleBar != nullptr) {
+        callbacks.titleBar->setActive(active);
+    } else {
+        callbacks.onActivationChanged(active);
+    }
+}
+
+void LinuxClientSideDecorationFilter::setWindowState(
+    QWidget *widget,
+    WidgetCallbacks &callbacks,
+    Qt::WindowStates windowState) {
+    windowState &= kTrackedWindowStates;
+    if (windowState == callbacks.windowState) {
+        return;
+    }
+    callbacks.windowState = windowState;
+    if (callbacks.titleBar != nullptr) {
+        callbacks.titleBar->onWindowStateChange(windowState);
+    } else {
+        callbacks.onWindowStateChanged(windowState);
+    }
+    this->updateVisibility(widget, callbacks);
+    this->updateShadow(widget, callbacks);
+    updateCompositorHints(widget, callbacks);
+    updateHitTestFrame(widget, callbacks);
+}
+
+LinuxClientSideDecorationFilter::WidgetCallbacks *
+LinuxClientSideDecorationFilter::callbacksForWindow(xcb_window_t window,
+                                                    QWidget **widget) {
+    const auto found = this->m_windows.constFind(window);
+    if (found == this->m_windows.constEnd()) {
+        return nullptr;
+    }
+    *widget = found.value();
+    return this->callbacksForWidget(*widget);
+}
+
+LinuxClientSideDecorationFilter::WidgetCallbacks *
+LinuxClientSideDecorationFilter::callbacksForWidget(
+    const QWidget *widget) const {
+    const auto *data =
+        static_cast<const WidgetData *>(widget->userData(widgetDataId()));
+    if (data == nullptr) {
+        return nullptr;
+    }
+    if (data->filter == this) {
+        return data->callbacks;
+    }
+    const auto found = lowerBound(this->m_callbacks, widget);
+    if (found == this->m_callbacks.end() || found->first != widget) {
+        return nullptr;
+    }
+    return found->second.get();
+}
+
+LinuxClientSideDecorationFilter::WidgetCallbacks *
+LinuxClientSideDecorationFilter::callbacksForWindowHandle(
+    const QWindow *window, QWidget **widget) const {
+    const auto found = lowerBound(this->m_windowHandles, window);
+    if (found == this->m_windowHandles.end() || found->first != window) {
+        return nullptr;
+    }
+    *widget = found->second;
+    return this->callbacksForWidget(*widget);
+}
+
+// Directions of _NET_WM_MOVERESIZE.
+enum MoveResizeDirection : std::uint32_t {
+    MoveResizeSizeTopLeft = 0,
+    MoveResizeSizeTop = 1,
+    MoveResizeSizeTopRight = 2,
+    MoveResizeSizeRight = 3,
+    MoveResizeSizeBottomRight = 4,
+    MoveResizeSizeBottom = 5,
+    MoveResizeSizeBottomLeft = 6,
+    MoveResizeSizeLeft = 7,
+    MoveResizeMove = 8,
+};
+
+static std::optional<MoveResizeDirection> directionForEdges(Qt::Edges edges) {
+    switch (static_cast<int>(edges)) {
+    case Qt::TopEdge | Qt::LeftEdge:
+        return MoveResizeSizeTopLeft;
+    case Qt::TopEdge:
+        return MoveResizeSizeTop;
+    case Qt::TopEdge | Qt::RightEdge:
+        return MoveResizeSizeTopRight;
+    case Qt::RightEdge:
+        return MoveResizeSizeRight;
+    case Qt::BottomEdge | Qt::RightEdge:
+        return MoveResizeSizeBottomRight;
+    case Qt::BottomEdge:
+        return MoveResizeSizeBottom;
+    case Qt::BottomEdge | Qt::LeftEdge:
+        return MoveResizeSizeBottomLeft;
+    case Qt::LeftEdge:
+        return MoveResizeSizeLeft;
+    default:
+        return std::nullopt;
+    }
+}
+
+static void sendMoveResize(QWidget *window,
+                           const QPoint &globalPos,
+                           MoveResizeDirection direction) {
+    QPlatformWindow *platformWindow = window->windowHandle()->handle();
+    const QPoint nativePos = QHighDpi::toNativePixels(
+        globalPos, platformWindow->screen()->screen());
+
+    xcb_client_message_event_t xev;
+    xev.response_type = XCB_CLIENT_MESSAGE;
+    xev.type = atom(X11Atom::NetWmMoveResize);
+    xev.sequence = 0;
+    xev.window = static_cast<xcb_window_t>(platformWindow->winId());
+    xev.format = 32;
+    xev.data.data32[0] = static_cast<std::uint32_t>(nativePos.x());
+    xev.data.data32[1] = static_cast<std::uint32_t>(nativePos.y());
+    xev.data.data32[2] = direction;
+    xev.data.data32[3] = XCB_BUTTON_INDEX_1;
+    xev.data.data32[4] = 0;
+
+    // The root window of the screen, as given by the connection setup.
+    const auto rootWindow =
+        static_cast<xcb_window_t>(QX11Info::appRootWindow());
+
+    std::uint32_t eventFlags = XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT |
+                               XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY;
+
+    xcb_ungrab_pointer(QX11Info::connection(), XCB_CURRENT_TIME);
+    xcb_send_event(QX11Info::connection(),
+                   false,
+                   rootWindow,
+                   eventFlags,
+                   reinterpret_cast<const char *>(&xev));
+}
+
+static bool startMoveResize(QWidget *widget,
+                            const QPoint &pos,
+                            Qt::Edges edges,
+                            MoveResizeDirection direction) {
+    const auto roundTripsBefore = x11RoundTrips();
+    QWidget *tlw = titleBarTopLevelWidget(widget);
+    bool started = false;
+
+    if (tlw->isWindow() && tlw->windowHandle() &&
+        !(tlw->windowFlags() & Qt::X11BypassWindowManagerHint) &&
+        !tlw->testAttribute(Qt::WA_DontShowOnScreen) &&
+        !tlw->hasHeightForWidth()) {
+        // QWindow maps through its cached position; the platform window
+        // would ask the X server to translate the coordinates.
+        const auto logicalPos =
+            tlw->windowHandle()->mapToGlobal(widget->mapTo(tlw, pos));
+        if (!s_windowManagerMovesWindows.has_value()) {
+            detectWindowManager();
+        }
+        if (*s_windowManagerMovesWindows) {
+            sendMoveResize(tlw, logicalPos, direction);
+            ClientMoveResize::watch(tlw, logicalPos, edges);
+        } else {
+            ClientMoveResize::start(tlw, logicalPos, edges);
+        }
+        started = true;
+    }
+    s_lastSystemMoveRoundTrips = x11RoundTrips() - roundTripsBefore;
+    return started;
+}
+
+bool startSystemMove(QWidget *widget, const QPoint &pos) {
+    return startMoveResize(widget, pos, Qt::Edges(), MoveResizeMove);
+}
+
+bool startSystemResize(QWidget *widget, const QPoint &pos, Qt::Edges edges) {
+    const auto direction = directionForEdges(edges);
+    if (!direction.has_value()) {
+        return false;
+    }
+    return startMoveResize(widget, pos, edges, *direction);
+}
+
+quint64 lastSystemMoveRoundTrips() {
+    return s_lastSystemMoveRoundTrips;
 }
 
 } // namespace CSD::Internal
@@ -1,31 +1,174 @@
 #pragma once
 
+#include <QAbstractNativeEventFilter>
+#include <QColor>
+#include <QHash>
 #include <QObject>
+#include <QRect>
+
+#include <xcb/xcb.h>
+
+#include "csdhittest.h"
+#include "csdtitlebarclient.h"
+#include "linuxframesync.h"
 
 #include <functional>
-#include <unordered_map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class QPoint;
+class QWidget;
+class QWindow;
 
 namespace CSD::Internal {
 
-class LinuxClientSideDecorationFilter : public QObject {
+// Asks the window manager to move the window of widget, as if its title bar
+// was dragged from pos, given in widget coordinates. Without a window manager
+// that handles the request, or when it ignores it, the client moves the
+// window itself. Returns false when the window cannot be moved this way: it
+// bypasses the window manager, is not shown on screen, has a height for its
+// width or has no window handle yet.
+bool startSystemMove(QWidget *widget, const QPoint &pos);
+// Likewise for a resize dragging edges, one edge or two forming a corner.
+bool startSystemResize(QWidget *widget, const QPoint &pos, Qt::Edges edges);
+// Round trips to the X server the last move or resize start waited for.
+quint64 lastSystemMoveRoundTrips();
+
+class LinuxClientSideDecorationFilter : public QObject,
+                                        public QAbstractNativeEventFilter {
     Q_OBJECT
 
 private:
-    using Callback = std::function<void()>;
+    using VisibilityCallback = std::function<void(bool)>;
+    using ActivationCallback = std::function<void(bool)>;
+    using WindowStateCallback = std::function<void(Qt::WindowStates)>;
+    // What the X server and the window manager tell about a window. It is
+    // visible on screen when it is mapped, not fully obscured, not hidden and
+    // on the current desktop.
+    struct WindowVisibility {
+        bool mapped = false;
+        bool obscured = false;
+        bool hidden = false;
+        quint32 desktop = 0xFFFFFFFF;
+        bool visible = false;
+    };
+    // A shadow of radius pixels drawn by the client around the window's
+    // content. margin is the part of the window it currently takes, none
+    // while maximized, full screen or without a compositing manager.
+    struct WindowShadow {
+        int radius = 0;
+        QColor color;
+        int margin = 0;
+    };
+    // What the compositor was last told, in device pixels. The opaque
+    // region is the window's content and empty when that is translucent.
+    struct CompositorHints {
+        QRect opaqueRegion;
+        bool bypass = false;
+        bool set = false;
+    };
     struct WidgetCallbacks {
-        Callback onActivationChanged;
-        Callback onWindowStateChanged;
-        WidgetCallbacks(Callback onActivationChanged,
-                        Callback onWindowStateChanged);
+        VisibilityCallback onVisibilityChanged;
+        ActivationCallback onActivationChanged;
+        WindowStateCallback onWindowStateChanged;
+        // As last reported through the callbacks.
+        bool active = false;
+        Qt::WindowStates windowState;
+        WindowVisibility visibility;
+        WindowShadow shadow;
+        CompositorHints compositorHints;
+        HitTestMap hitTestMap;
+        // Null unless the server and Qt support the sync protocol.
+        std::unique_ptr<FrameSync> frameSync;
+        // Set once the window is shown, and again when it is replaced.
+        xcb_window_t window = XCB_NONE;
+        QWindow *windowHandle = nullptr;
+        // Told about changes instead of the callbacks when set.
+        TitleBarClient *titleBar = nullptr;
+        WidgetCallbacks() = default;
+        WidgetCallbacks(VisibilityCallback onVisibilityChanged,
+                        ActivationCallback onActivationChanged,
+                        WindowStateCallback onWindowStateChanged);
     };
-    std::unordered_map<QWidget *, WidgetCallbacks> m_callbacks;
+    struct WidgetData;
+    // Both sorted by their first member for binary search. The callbacks
+    // are allocated separately so references to them survive insertions,
+    // and so that the WidgetData on each widget can point at them.
+    std::vector<std::pair<QWidget *, std::unique_ptr<WidgetCallbacks>>>
+        m_callbacks;
+    std::vector<std::pair<QWindow *, QWidget *>> m_windowHandles;
+    // The decorated widgets by their X11 window.
+    QHash<xcb_window_t, QWidget *> m_windows;
+    quint32 m_currentDesktop = 0;
+    bool m_filtersApplication = false;
+    // Edges whose resize cursor overrides the application cursor.
+    Qt::Edges m_cursorEdges;
+
+    void selectVisibilityEvents(QWidget *widget, WindowVisibility &visibility);
+    void updateVisibility(QWidget *widget, WidgetCallbacks &callbacks);
+    void setActive(WidgetCallbacks &callbacks, bool active);
+    void setWindowState(QWidget *widget,
+                        WidgetCallbacks &callbacks,
+                        Qt::WindowStates windowState);
+    WidgetCallbacks *callbacksForWidget(const QWidget *widget) const;
+    WidgetCallbacks *callbacksForWindow(xcb_window_t window,
+                                        QWidget **widget);
+    WidgetCallbacks *callbacksForWindowHandle(const QWindow *window,
+                                              QWidget **widget) const;
+    void registerWidget(QWidget *widget,
+                        std::unique_ptr<WidgetCallbacks> callbacks);
+    void unregisterWidget(QObject *object);
+    // Deletes the WidgetData this filter left on object, if any.
+    void releaseWidgetData(QObject *object) const;
+    // Sets up the native window of widget, on its first Show and whenever
+    // a shown widget gets a new one.
+    void registerWindow(QWidget *widget, WidgetCallbacks &callbacks);
+    // Drops what was set up for the native window it had.
+    void forgetWindow(WidgetCallbacks &callbacks);
+    bool windowEventFilter(QWindow *window, QEvent *event);
+    // Starts a frame for the UpdateRequest or Expose event about to be
+    // delivered to widget, and ends it after the event was delivered.
+    void bracketFrame(QWidget *widget, FrameSync &frameSync);
+    void setUpFrameSync(QWidget *widget, WidgetCallbacks &callbacks);
+    void updateShadow(QWidget *widget, WidgetCallbacks &callbacks);
+    static void updateCompositorHints(QWidget *widget,
+                                      WidgetCallbacks &callbacks);
+    static void updateHitTestFrame(QWidget *widget,
+                                   WidgetCallbacks &callbacks);
+    static void paintShadow(QWidget *widget, const WindowShadow &shadow);
+    static void updateShadowRegions(QWidget *widget,
+                                    const WindowShadow &shadow);
+    void setResizeCursor(Qt::Edges edges);
 
 public:
     explicit LinuxClientSideDecorationFilter(QObject *parent = nullptr);
     ~LinuxClientSideDecorationFilter() override;
     bool eventFilter(QObject *watched, QEvent *event) override;
+    bool nativeEventFilter(const QByteArray &eventType,
+                           void *message,
+                           long *result) override;
+    // The callbacks get the new value and are called once per change. On
+    // X11 activation and window state are read from the X events directly,
+    // ahead of the widget events Qt derives from them.
     void apply(QWidget *widget,
-               Callback onActivationChanged,
-               Callback onWindowStateChanged);
+               VisibilityCallback onVisibilityChanged,
+               ActivationCallback onActivationChanged,
+               WindowStateCallback onWindowStateChanged);
+    // Decorates widget for titleBar, which is updated directly instead of
+    // through callbacks.
+    void apply(QWidget *widget, TitleBarClient *titleBar);
+    // For an event filter installed on the application that passes on the
+    // events of all objects. apply() then leaves the widgets' and windows'
+    // own event filters alone.
+    void setFiltersApplication(bool on);
+    // Draws a shadow around widget, which must have been applied and not be
+    // shown yet. The shadow's outer band also serves as the resize border.
+    void setShadow(QWidget *widget,
+                   int radius,
+                   const QColor &color = QColor(0, 0, 0, 110));
+    // The timings of widget's most recent frames, oldest first. Empty when
+    // the window does not take part in the sync protocol.
+    std::vector<FrameTiming> frameTimings(QWidget *widget) const;
 };
 } // namespace CSD::Internal
@@ -0,0 +1,153 @@
+#include "linuxframesync.h"
+
+#include "linuxatoms.h"
+
+#include <QX11Info>
+
+namespace CSD::Internal {
+
+static qint64 value64(std::uint32_t low, std::uint32_t high) {
+    return static_cast<qint64>((static_cast<quint64>(high) << 32u) | low);
+}
+
+FrameSync::FrameSync(xcb_window_t window, xcb_sync_counter_t basicCounter) {
+    auto *connection = QX11Info::connection();
+    const auto *sync = xcb_get_extension_data(connection, &xcb_sync_id);
+    if (sync == nullptr || !sync->present || basicCounter == XCB_NONE) {
+        return;
+    }
+    this->m_counter = xcb_generate_id(connection);
+    xcb_sync_create_counter(
+        connection, this->m_counter, xcb_sync_int64_t{0, 0});
+    // The basic counter comes first, the extended one second.
+    const xcb_sync_counter_t counters[] = {basicCounter, this->m_counter};
+    xcb_change_property(connection,
+                        XCB_PROP_MODE_REPLACE,
+                        window,
+                        X11Atoms::instance().atom(
+                            X11Atom::NetWmSyncRequestCounter),
+                        XCB_ATOM_CARDINAL,
+                        32,
+                        2,
+                        counters);
+}
+
+FrameSync::~FrameSync() {
+    // The connection is gone when the application shuts down, taking the
+    // counter with it.
+    auto *connection = QX11Info::connection();
+    if (this->m_counter != XCB_NONE && connection != nullptr) {
+        xcb_sync_destroy_counter(connection, this->m_counter);
+    }
+}
+
+bool FrameSync::isValid() const {
+    return this->m_counter != XCB_NONE;
+}
+
+void FrameSync::beginFrame() {
+    if (!this->isValid() || this->m_inFrame) {
+        return;
+    }
+    this->m_inFrame = true;
+    this->m_frameTimer.start();
+    // An odd value marks a frame in progress.
+    if (this->m_value % 2 == 0) {
+        this->setCounter(this->m_value + 1);
+    }
+}
+
+bool FrameSync::isInFrame() const {
+    return this->m_inFrame;
+}
+
+void FrameSync::endFrame() {
+    if (!this->m_inFrame) {
+        return;
+    }
+    this->m_inFrame = false;
+    // An even value marks a complete frame; one that answers a sync request
+    // must reach the requested value.
+    auto value = this->m_value + 1;
+    if (this->m_requestedValue > value) {
+        value = this->m_requestedValue;
+    }
+    if (value % 2 != 0) {
+        ++value;
+    }
+    this->m_requestedValue = 0;
+    this->setCounter(value);
+
+    auto &timing = this->m_timings[this->m_nextTiming];
+    timing = FrameTiming();
+    timing.serial = value;
+    timing.paintNanoseconds = this->m_frameTimer.nsecsElapsed();
+    this->m_nextTiming = (this->m_nextTiming + 1) % kTimingCount;
+}
+
+void FrameSync::syncRequested(const xcb_client_message_event_t *event) {
+    // data32[4] is set when the window manager asks for the extended
+    // counter; basic requests are Qt's.
+    if (!this->isValid() || event->data.data32[4] == 0) {
+        return;
+    }
+    this->m_requestedValue =
+        value64(event->data.data32[2], event->data.data32[3]);
+}
+
+void FrameSync::frameDrawn(const xcb_client_message_event_t *event) {
+    auto *timing =
+        this->timingFor(value64(event->data.data32[0], event->data.data32[1]));
+    if (timing != nullptr) {
+        timing->drawnMicroseconds =
+            value64(event->data.data32[2], event->data.data32[3]);
+    }
+}
+
+void FrameSync::frameTimings(const xcb_client_message_event_t *event) {
+    auto *timing =
+        this->timingFor(value64(event->data.data32[0], event->data.data32[1]));
+    if (timing != nullptr) {
+        timing->presentationOffsetMicroseconds =
+            static_cast<qint32>(event->data.data32[2]);
+        timing->refreshIntervalMicroseconds = event->data.data32[3];
+        timing->frameDelayMicroseconds = event->data.data32[4];
+    }
+}
+
+std::vector<FrameTiming> FrameSync::timings() const {
+    auto result = std::vector<FrameTiming>();
+    result.reserve(kTimingCount);
+    for (std::size_t i = 0; i < kTimingCount; ++i) {
+        const auto &timing =
+            this->m_timings[(this->m_nextTiming + i) % kTimingCount];
+        if (timing.serial != 0) {
+            result.push_back(timing);
+        }
+    }
+    return result;
+}
+
+void FrameSync::setCounter(qint64 value) {
+    this->m_value = value;
+    const auto bits = static_cast<quint64>(value);
+    xcb_sync_set_counter(
+        QX11Info::connection(),
+        this->m_counter,
+        xcb_sync_int64_t{static_cast<std::int32_t>(bits >> 32u),
+                         static_cast<std::uint32_t>(bits)});
+}
+
+FrameTiming *FrameSync::timingFor(qint64 serial) {
+    if (serial == 0) {
+        return nullptr;
+    }
+    for (auto &timing : this->m_timings) {
+        if (timing.serial == serial) {
+            return &timing;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace CSD::Internal
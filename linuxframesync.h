@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+#include <xcb/sync.h>
+#include <xcb/xcb.h>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace CSD::Internal {
+
+// What is known about one frame of a window. serial is the value of the
+// extended sync counter once the frame was complete.
+struct FrameTiming {
+    qint64 serial = 0;
+    // From the start of the repaint until it was handed to the X server.
+    qint64 paintNanoseconds = 0;
+    // The rest is reported by the compositor and stays 0 until it has.
+    // drawnMicroseconds is on the compositor's monotonic clock.
+    qint64 drawnMicroseconds = 0;
+    qint32 presentationOffsetMicroseconds = 0;
+    quint32 refreshIntervalMicroseconds = 0;
+    quint32 frameDelayMicroseconds = 0;
+};
+
+// The client side of the extended _NET_WM_SYNC_REQUEST protocol for one
+// window. Qt answers basic sync requests itself; this adds the extended
+// counter, which tells the window manager and the compositor when a frame
+// starts and when it is complete, so they pace resizes by the client's
+// painting and report back when each frame reached the screen.
+class FrameSync {
+public:
+    // basicCounter is the counter Qt set up for window. Does nothing unless
+    // the server has the SYNC extension and Qt created a counter.
+    FrameSync(xcb_window_t window, xcb_sync_counter_t basicCounter);
+    ~FrameSync();
+    FrameSync(const FrameSync &) = delete;
+    FrameSync &operator=(const FrameSync &) = delete;
+
+    bool isValid() const;
+
+    // Bracket the repaint of one frame and its flush to the X server.
+    void beginFrame();
+    void endFrame();
+    bool isInFrame() const;
+
+    // Take the _NET_WM_SYNC_REQUEST, _NET_WM_FRAME_DRAWN and
+    // _NET_WM_FRAME_TIMINGS messages sent to the window.
+    void syncRequested(const xcb_client_message_event_t *event);
+    void frameDrawn(const xcb_client_message_event_t *event);
+    void frameTimings(const xcb_client_message_event_t *event);
+
+    // The most recent frames, oldest first.
+    std::vector<FrameTiming> timings() const;
+
+private:
+    static constexpr std::size_t kTimingCount = 64;
+
+    void setCounter(qint64 value);
+    FrameTiming *timingFor(qint64 serial);
+
+    xcb_sync_counter_t m_counter = XCB_NONE;
+    qint64 m_value = 0;
+    // Value asked for by the last extended sync request, 0 when answered.
+    qint64 m_requestedValue = 0;
+    bool m_inFrame = false;
+    QElapsedTimer m_frameTimer;
+    std::array<FrameTiming, kTimingCount> m_timings = {};
+    std::size_t m_nextTiming = 0;
+};
+
+} // namespace CSD::Internal
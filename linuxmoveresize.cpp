@@ -0,0 +1,245 @@
+#include "linuxmoveresize.h"
+
+#include "linuxatoms.h"
+
+#include <QMouseEvent>
+#include <QScreen>
+#include <QWidget>
+#include <QWindow>
+
+#include <QX11Info>
+
+#include <xcb/xcb.h>
+
+#include <cstdlib>
+
+namespace CSD::Internal {
+
+// How long a window manager gets to grab the pointer before a request it was
+// sent counts as ignored.
+constexpr static qint64 kTakeOverDelay = 200;
+
+static ClientMoveResize *s_session = nullptr;
+static quint64 s_motionEvents = 0;
+static quint64 s_geometryUpdates = 0;
+
+void ClientMoveResize::start(QWidget *window,
+                             const QPoint &globalPos,
+                             Qt::Edges edges) {
+    begin(window, globalPos, edges, Mode::Following);
+}
+
+void ClientMoveResize::watch(QWidget *window,
+                             const QPoint &globalPos,
+                             Qt::Edges edges) {
+    begin(window, globalPos, edges, Mode::Watching);
+}
+
+quint64 ClientMoveResize::motionEvents() {
+    return s_motionEvents;
+}
+
+quint64 ClientMoveResize::geometryUpdates() {
+    return s_geometryUpdates;
+}
+
+void ClientMoveResize::begin(QWidget *window,
+                             const QPoint &globalPos,
+                             Qt::Edges edges,
+                             Mode mode) {
+    if (s_session != nullptr) {
+        s_session->finish();
+    }
+    s_session = new ClientMoveResize(window, globalPos, edges, mode);
+}
+
+ClientMoveResize::ClientMoveResize(QWidget *window,
+                                   const QPoint &globalPos,
+                                   Qt::Edges edges,
+                                   Mode mode)
+    : QObject(window), m_window(window), m_pressPos(globalPos),
+      m_startGeometry(window->geometry()), m_edges(edges), m_mode(mode),
+      m_latestPos(globalPos) {
+    this->m_sinceStart.start();
+    const auto *screen = window->windowHandle()->screen();
+    const auto refreshRate = screen != nullptr ? screen->refreshRate() : 60.0;
+    this->m_frameTimer.setTimerType(Qt::PreciseTimer);
+    this->m_frameTimer.setInterval(qMax(1, qRound(1000.0 / refreshRate)));
+    connect(&this->m_frameTimer, &QTimer::timeout, this, [this] {
+        if (this->m_geometryPending) {
+            this->applyGeometry();
+        } else {
+            this->m_frameTimer.stop();
+        }
+    });
+    window->windowHandle()->installEventFilter(this);
+}
+
+ClientMoveResize::~ClientMoveResize() {
+    // Deleted along with its window when that goes away mid session.
+    if (this->m_pointerGrabbed) {
+        xcb_ungrab_pointer(QX11Info::connection(), XCB_CURRENT_TIME);
+    }
+    if (s_session == this) {
+        s_session = nullptr;
+    }
+}
+
+bool ClientMoveResize::eventFilter([[maybe_unused]] QObject *watched,
+                                   QEvent *event) {
+    switch (event->type()) {
+    case QEvent::MouseMove: {
+        auto *mouseEvent = static_cast<QMouseEvent *>(event);
+        if (this->m_mode == Mode::Watching) {
+            if (this->m_sinceStart.elapsed() < kTakeOverDelay) {
+                return false;
+            }
+            // A released button is never stale, only a held one may be.
+            if (!(mouseEvent->buttons() & Qt::LeftButton) ||
+                !this->takeOver()) {
+                this->finish();
+                return false;
+            }
+        }
+        ++s_motionEvents;
+        this->follow(mouseEvent->globalPos());
+        return true;
+    }
+    case QEvent::MouseButtonRelease: {
+        auto *mouseEvent = static_cast<QMouseEvent *>(event);
+        if (mouseEvent->button() == Qt::LeftButton) {
+            if (this->m_mode == Mode::Following) {
+                this->m_latestPos = mouseEvent->globalPos();
+                this->m_geometryPending = true;
+            }
+            this->finish();
+        }
+        return false;
+    }
+    case QEvent::MouseButtonPress:
+        // Left over from a request the window manager ran.
+        this->finish();
+        return false;
+    case QEvent::Move:
+    case QEvent::Resize:
+    case QEvent::Leave:
+    case QEvent::FocusOut:
+        // The window manager acts on the request, or the pointer went
+        // elsewhere; either way there is nothing left to take over.
+        if (this->m_mode == Mode::Watching) {
+            this->finish();
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+bool ClientMoveResize::takeOver() {
+    if (this->m_window == nullptr ||
+        this->m_window->geometry() != this->m_startGeometry) {
+        return false;
+    }
+    // Qt's button state is stale after a window manager ran a request, so
+    // ask the server whether the button is really still down.
+    auto *connection = QX11Info::connection();
+    const auto root = static_cast<xcb_window_t>(QX11Info::appRootWindow());
+    countX11RoundTrip();
+    auto *reply = xcb_query_pointer_reply(
+        connection, xcb_query_pointer(connection, root), nullptr);
+    const bool buttonHeld =
+        reply != nullptr && (reply->mask & XCB_BUTTON_MASK_1) != 0;
+    std::free(reply);
+    if (!buttonHeld) {
+        return false;
+    }
+
+    // The press grab ended when the request was sent; grab again so the
+    // pointer cannot escape the window while it catches up.
+    const auto eventMask = static_cast<std::uint16_t>(
+        XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_POINTER_MOTION);
+    const auto cookie =
+        xcb_grab_pointer(connection,
+                         false,
+                         static_cast<xcb_window_t>(this->m_window->winId()),
+                         eventMask,
+                         XCB_GRAB_MODE_ASYNC,
+                         XCB_GRAB_MODE_ASYNC,
+                         XCB_NONE,
+                         XCB_NONE,
+                         XCB_CURRENT_TIME);
+    xcb_discard_reply(connection, cookie.sequence);
+    this->m_pointerGrabbed = true;
+    this->m_mode = Mode::Following;
+    return true;
+}
+
+void ClientMoveResize::follow(const QPoint &globalPos) {
+    // Only the latest position counts; the frame timer picks it up unless
+    // the previous frame is long enough ago to apply it right away.
+    this->m_latestPos = globalPos;
+    this->m_geometryPending = true;
+    if (!this->m_frameTimer.isActive()) {
+        this->applyGeometry();
+        this->m_frameTimer.start();
+    }
+}
+
+void ClientMoveResize::applyGeometry() {
+    this->m_geometryPending = false;
+    if (this->m_window == nullptr) {
+        return;
+    }
+    ++s_geometryUpdates;
+    const auto delta = this->m_latestPos - this->m_pressPos;
+    const auto &start = this->m_startGeometry;
+    if (!this->m_edges) {
+        this->m_window->move(start.topLeft() + delta);
+        return;
+    }
+
+    const auto minimum = this->m_window->minimumSize()
+                             .expandedTo(this->m_window->minimumSizeHint())
+                             .expandedTo(QSize(1, 1));
+    const auto maximum = this->m_window->maximumSize();
+    auto rect = start;
+    if (this->m_edges & Qt::LeftEdge) {
+        const auto width = qBound(
+            minimum.width(), start.width() - delta.x(), maximum.width());
+        rect.setLeft(start.right() + 1 - width);
+    }
+    if (this->m_edges & Qt::RightEdge) {
+        rect.setWidth(qBound(
+            minimum.width(), start.width() + delta.x(), maximum.width()));
+    }
+    if (this->m_edges & Qt::TopEdge) {
+        const auto height = qBound(
+            minimum.height(), start.height() - delta.y(), maximum.height());
+        rect.setTop(start.bottom() + 1 - height);
+    }
+    if (this->m_edges & Qt::BottomEdge) {
+        rect.setHeight(qBound(
+            minimum.height(), start.height() + delta.y(), maximum.height()));
+    }
+    this->m_window->setGeometry(rect);
+}
+
+void ClientMoveResize::finish() {
+    this->m_frameTimer.stop();
+    if (this->m_geometryPending) {
+        this->applyGeometry();
+    }
+    if (this->m_pointerGrabbed) {
+        xcb_ungrab_pointer(QX11Info::connection(), XCB_CURRENT_TIME);
+        this->m_pointerGrabbed = false;
+    }
+    if (this->m_window != nullptr && this->m_window->windowHandle()) {
+        this->m_window->windowHandle()->removeEventFilter(this);
+    }
+    if (s_session == this) {
+        s_session = nullptr;
+    }
+    this->deleteLater();
+}
+
+} // namespace CSD::Internal
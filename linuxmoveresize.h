@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPoint>
+#include <QPointer>
+#include <QRect>
+#include <QTimer>
+
+class QWidget;
+
+namespace CSD::Internal {
+
+// Moves or resizes a top-level window from the client, for when no window
+// manager runs the _NET_WM_MOVERESIZE request. The window follows the latest
+// pointer position until the left button is released; pointer motion is
+// compressed and geometry changes are applied at most once per frame of the
+// window's screen.
+class ClientMoveResize : public QObject {
+    Q_OBJECT
+
+public:
+    // Starts following the pointer right away. globalPos is where the left
+    // button went down and edges are empty for a move.
+    static void start(QWidget *window,
+                      const QPoint &globalPos,
+                      Qt::Edges edges);
+    // The request went to the window manager; only takes over if the window
+    // is still unchanged and the button still held once the window manager
+    // had time to grab the pointer. Watching ends when the pointer leaves
+    // the window or it loses focus.
+    static void watch(QWidget *window,
+                      const QPoint &globalPos,
+                      Qt::Edges edges);
+
+    static quint64 motionEvents();
+    static quint64 geometryUpdates();
+
+    ~ClientMoveResize() override;
+
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    enum class Mode { Watching, Following };
+
+    ClientMoveResize(QWidget *window,
+                     const QPoint &globalPos,
+                     Qt::Edges edges,
+                     Mode mode);
+
+    static void begin(QWidget *window,
+                      const QPoint &globalPos,
+                      Qt::Edges edges,
+                      Mode mode);
+    bool takeOver();
+    void follow(const QPoint &globalPos);
+    void applyGeometry();
+    void finish();
+
+    QPointer<QWidget> m_window;
+    QPoint m_pressPos;
+    QRect m_startGeometry;
+    Qt::Edges m_edges;
+    Mode m_mode;
+    QElapsedTimer m_sinceStart;
+    QTimer m_frameTimer;
+    QPoint m_latestPos;
+    bool m_geometryPending = false;
+    bool m_pointerGrabbed = false;
+};
+
+} // namespace CSD::Internal
@@ -1,68 +1,34 @@
 #include <QApplication>
 #include <QBoxLayout>
+#include <QDialog>
 #include <QMainWindow>
 #include <QPushButton>
 
-#include "csdtitlebar.h"
-#ifdef _WIN32
-#include "win32csd.h"
-#else
-#include "linuxcsd.h"
-#endif
+#include "csddecorationmanager.h"
 
 class DemoWindow : public QMainWindow {
 
 public:
     DemoWindow(QWidget *parent = nullptr) : QMainWindow(parent) {
         this->setCentralWidget(new QWidget(this));
-        auto *layout = new QVBoxLayout;
-        layout->setMargin(0);
+        auto *layout = new QHBoxLayout;
         this->centralWidget()->setLayout(layout);
-        auto *button = new QPushButton("Toggle full screen", this);
-        connect(button, &QPushButton::clicked, this, [this] {
+        auto *fullScreenButton = new QPushButton("Toggle full screen", this);
+        connect(fullScreenButton, &QPushButton::clicked, this, [this] {
             this->setWindowState(this->windowState() ^ Qt::WindowFullScreen);
         });
-        auto *centralLayout = new QHBoxLayout();
-        auto *subWidget = new QWidget(this);
-        centralLayout->addStretch();
-        centralLayout->addWidget(button);
-        centralLayout->addStretch();
-        subWidget->setLayout(centralLayout);
-        this->m_titleBar = new CSD::TitleBar(
-#ifdef _WIN32
-            CSD::CaptionButtonStyle::win,
-#else
-            CSD::CaptionButtonStyle::custom,
-#endif
-            QIcon(),
-            this);
-        layout->addWidget(this->m_titleBar);
-        layout->addWidget(subWidget);
-
-        connect(
-            this->m_titleBar, &CSD::TitleBar::minimizeClicked, this, [this]() {
-                this->setWindowState(this->windowState() |
-                                     Qt::WindowMinimized);
-            });
-        connect(this->m_titleBar,
-                &CSD::TitleBar::maximizeRestoreClicked,
-                this,
-                [this]() {
-                    this->setWindowState(this->windowState() ^
-                                         Qt::WindowMaximized);
-                });
-        connect(this->m_titleBar,
-                &CSD::TitleBar::closeClicked,
-                this,
-                &QWidget::close);
-    }
-
-    CSD::TitleBar *titleBar() {
-        return this->m_titleBar;
+        auto *dialogButton = new QPushButton("Open dialog", this);
+        connect(dialogButton, &QPushButton::clicked, this, [this] {
+            auto *dialog = new QDialog(this);
+            dialog->setAttribute(Qt::WA_DeleteOnClose);
+            dialog->resize(320, 200);
+            dialog->show();
+        });
+        layout->addStretch();
+        layout->addWidget(fullScreenButton);
+        layout->addWidget(dialogButton);
+        layout->addStretch();
     }
-
-private:
-    CSD::TitleBar *m_titleBar;
 };
 
 int main(int argc, char *argv[]) {
@@ -70,29 +36,16 @@ int main(int argc, char *argv[]) {
     QApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
     auto *app = new QApplication(argc, argv);
     QApplication::setApplicationName("qt-csd");
-    auto *mainWindow = new DemoWindow();
-    mainWindow->resize(640, 480);
 
-#ifdef _WIN32
-    auto *filter = new CSD::Internal::Win32ClientSideDecorationFilter(app);
-    app->installNativeEventFilter(filter);
-#else
-    auto *filter = new CSD::Internal::LinuxClientSideDecorationFilter(app);
-#endif
-    filter->apply(
-        mainWindow,
-#ifdef _WIN32
-        [mainWindow]() { return mainWindow->titleBar()->hovered(); },
+    auto *manager = CSD::DecorationManager::instance();
+    manager->setDecoratedWindows(CSD::DecoratedMainWindows |
+                                 CSD::DecoratedDialogs);
+#ifndef _WIN32
+    manager->setShadowRadius(16);
 #endif
-        [mainWindow] {
-            const bool on = mainWindow->isActiveWindow();
-            mainWindow->titleBar()->setActive(on);
-        },
-        [mainWindow] {
-            mainWindow->titleBar()->onWindowStateChange(
-                mainWindow->windowState());
-        });
 
+    auto *mainWindow = new DemoWindow();
+    mainWindow->resize(640, 480);
     mainWindow->show();
     return app->exec();
 }
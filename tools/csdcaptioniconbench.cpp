@@ -0,0 +1,164 @@
+// Times the caption icon lookup through the tables in csdcaptionicons.h
+// against the branch tree it replaced, over every style, button and state,
+// and checks that both pick the same icons.
+
+#include "csdcaptionicons.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace CSD;
+using namespace CSD::Internal;
+
+// The lookup before the tables, with the paths the tables hold today.
+static std::array<QStringView, 3> branchPaths(bool active,
+                                              bool maximized,
+                                              bool hovered,
+                                              bool pressed,
+                                              CaptionButtonStyle style) {
+    auto buf = std::array<QStringView, 3>();
+    switch (style) {
+    case CaptionButtonStyle::custom:
+        buf[0] = u":/resources/titlebar/custom/chrome-minimize.svg";
+        if (maximized) {
+            buf[1] = u":/resources/titlebar/custom/chrome-restore.svg";
+        } else {
+            buf[1] = u":/resources/titlebar/custom/chrome-maximize.svg";
+        }
+        buf[2] = u":/resources/titlebar/custom/chrome-close.svg";
+        break;
+    case CaptionButtonStyle::win:
+        buf[0] = u":/resources/titlebar/win/chrome-minimize.svg";
+        if (maximized) {
+            buf[1] = u":/resources/titlebar/win/chrome-restore.svg";
+        } else {
+            buf[1] = u":/resources/titlebar/win/chrome-maximize.svg";
+        }
+        buf[2] = u":/resources/titlebar/win/chrome-close.svg";
+        break;
+    case CaptionButtonStyle::mac:
+        if (pressed) {
+            buf[0] = u":/resources/titlebar/mac/minimize-pressed.png";
+            if (maximized) {
+                buf[1] = u":/resources/titlebar/mac/"
+                         u"maximize-restore-maximized-pressed.png";
+            } else {
+                buf[1] = u":/resources/titlebar/mac/"
+                         u"maximize-restore-normal-pressed.png";
+            }
+            buf[2] = u":/resources/titlebar/mac/close-pressed.png";
+        } else if (hovered) {
+            buf[0] = u":/resources/titlebar/mac/minimize-hovered.png";
+            if (maximized) {
+                buf[1] = u":/resources/titlebar/mac/"
+                         u"maximize-restore-maximized-hovered.png";
+            } else {
+                buf[1] = u":/resources/titlebar/mac/"
+                         u"maximize-restore-normal-hovered.png";
+            }
+            buf[2] = u":/resources/titlebar/mac/close-hovered.png";
+        } else if (active) {
+            buf[0] = u":/resources/titlebar/mac/minimize.png";
+            buf[1] = u":/resources/titlebar/mac/maximize-restore.png";
+            buf[2] = u":/resources/titlebar/mac/close.png";
+        } else {
+            buf[0] = u":/resources/titlebar/mac/inactive.png";
+            buf[1] = u":/resources/titlebar/mac/inactive.png";
+            buf[2] = u":/resources/titlebar/mac/inactive.png";
+        }
+        break;
+    }
+    return buf;
+}
+
+struct Lookup {
+    CaptionButtonStyle style;
+    bool active;
+    bool maximized;
+    bool hovered;
+    bool pressed;
+};
+
+template <typename Function>
+static double nanosecondsPerLookup(const std::vector<Lookup> &lookups,
+                                   int rounds,
+                                   quintptr &checksum,
+                                   Function function) {
+    auto timer = QElapsedTimer();
+    timer.start();
+    for (auto round = 0; round < rounds; ++round) {
+        for (const auto &lookup : lookups) {
+            const auto paths = function(lookup.active,
+                                        lookup.maximized,
+                                        lookup.hovered,
+                                        lookup.pressed,
+                                        lookup.style);
+            checksum += reinterpret_cast<quintptr>(paths[0].data()) ^
+                        static_cast<quintptr>(paths[1].size()) ^
+                        reinterpret_cast<quintptr>(paths[2].data());
+        }
+    }
+    return static_cast<double>(timer.nsecsElapsed()) /
+           (static_cast<double>(rounds) *
+            static_cast<double>(lookups.size()));
+}
+
+int main(int argc, char *argv[]) {
+    const auto rounds = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100000;
+
+    // Every style and state, shuffled so the branches are not predictable
+    // from the loop alone.
+    auto lookups = std::vector<Lookup>();
+    for (auto style : {CaptionButtonStyle::custom,
+                       CaptionButtonStyle::win,
+                       CaptionButtonStyle::mac}) {
+        if (captionStyleInfo(style).icons == nullptr) {
+            continue;
+        }
+        for (auto states = 0; states < 16; ++states) {
+            lookups.push_back({style,
+                               (states & CaptionButtonActive) != 0,
+                               (states & CaptionButtonMaximized) != 0,
+                               (states & CaptionButtonHovered) != 0,
+                               (states & CaptionButtonPressed) != 0});
+        }
+    }
+    auto seed = 0x2545f491u;
+    for (auto i = lookups.size(); i > 1; --i) {
+        seed = seed * 1664525u + 1013904223u;
+        std::swap(lookups[i - 1], lookups[seed % i]);
+    }
+
+    for (const auto &lookup : lookups) {
+        const auto table = captionIconPathsForState(lookup.active,
+                                                    lookup.maximized,
+                                                    lookup.hovered,
+                                                    lookup.pressed,
+                                                    lookup.style);
+        const auto branch = branchPaths(lookup.active,
+                                        lookup.maximized,
+                                        lookup.hovered,
+                                        lookup.pressed,
+                                        lookup.style);
+        if (table != branch) {
+            std::fprintf(stderr, "table and branch tree disagree\n");
+            return 1;
+        }
+    }
+
+    auto checksum = quintptr(0);
+    const auto branch =
+        nanosecondsPerLookup(lookups, rounds, checksum, branchPaths);
+    const auto table = nanosecondsPerLookup(
+        lookups, rounds, checksum, captionIconPathsForState);
+    std::printf("%zu lookups x %d rounds\n", lookups.size(), rounds);
+    std::printf("branch tree %8.2f ns/lookup\n", branch);
+    std::printf("table       %8.2f ns/lookup\n", table);
+    std::printf("(checksum %llx)\n",
+                static_cast<unsigned long long>(checksum));
+    return 0;
+}
@@ -0,0 +1,89 @@
+// Starts window moves and resizes from the title bar of a shown window and
+// reports how long handing each one over to the move and resize backend
+// took, as recorded by dragStartLatency(). The backend follows the platform
+// plugin, so run it on the display to measure: an X server with or without
+// a window manager for the xcb backend, or a Wayland compositor, for
+// instance a headless weston with QT_QPA_PLATFORM=wayland, for QWindow.
+
+#include "csdsystemmove.h"
+#include "csdtitlebar.h"
+
+#include <QApplication>
+#include <QBoxLayout>
+#include <QIcon>
+#include <QWidget>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+
+using namespace CSD;
+using namespace CSD::Internal;
+
+static const char *backendName(MoveResizeBackend backend) {
+    switch (backend) {
+    case MoveResizeBackend::None:
+        return "none";
+    case MoveResizeBackend::Xcb:
+        return "xcb";
+    case MoveResizeBackend::QWindow:
+        return "QWindow";
+    }
+    return "";
+}
+
+int main(int argc, char *argv[]) {
+    auto app = QApplication(argc, argv);
+    const auto drags = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200;
+
+    auto window = QWidget();
+    window.setWindowFlag(Qt::FramelessWindowHint);
+    auto *layout = new QVBoxLayout(&window);
+    layout->setContentsMargins(0, 0, 0, 0);
+    auto *titleBar = new TitleBar(CaptionButtonStyle::custom, QIcon());
+    layout->addWidget(titleBar);
+    layout->addStretch(1);
+    window.resize(800, 600);
+    window.show();
+    QApplication::processEvents();
+
+    const Qt::Edges edges[] = {
+        Qt::Edges(),
+        Qt::RightEdge,
+        Qt::BottomEdge,
+        Qt::RightEdge | Qt::BottomEdge,
+    };
+    const auto backend = moveResizeBackend();
+    int refused = 0;
+    for (int i = 0; i < drags; ++i) {
+        const auto edge = edges[i % std::size(edges)];
+        const auto pos = QPoint(titleBar->width() / 2, titleBar->height() / 2);
+        const bool started = !edge ? startWindowMove(titleBar, pos)
+                                   : startWindowResize(titleBar, pos, edge);
+        if (!started) {
+            ++refused;
+        }
+        // Lets the previous drag wind down before the next one starts.
+        QApplication::processEvents();
+    }
+
+    const auto latency = dragStartLatency(backend);
+    const auto mean = latency.count == 0
+                          ? 0.0
+                          : static_cast<double>(latency.totalNanoseconds) /
+                                latency.count / 1000.0;
+    std::printf("%-8s  %7s  %7s  %9s  %9s\n",
+                "backend",
+                "started",
+                "refused",
+                "mean us",
+                "max us");
+    std::printf("%-8s  %7llu  %7d  %9.2f  %9.2f\n",
+                backendName(backend),
+                static_cast<unsigned long long>(latency.count),
+                refused,
+                mean,
+                static_cast<double>(latency.maxNanoseconds) / 1000.0);
+    return 0;
+}
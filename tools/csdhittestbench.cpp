@@ -0,0 +1,121 @@
+// Times the Linux filter's per mouse move hit test: HitTestMap::hitTest()
+// against recomputing the resize edges from the widget's state and size
+// limits, as the filter did before the map, over a pointer path across a
+// shadowed window. Both must agree on the edges.
+
+#include "csdhittest.h"
+#include "csdresizeedges.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QWidget>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace CSD::Internal;
+
+// As a DecorationManager window with a 16 pixel shadow.
+static constexpr int kShadowMargin = 16;
+
+// What the filter computed on each move before the map.
+static Qt::Edges recomputedEdges(const QWidget &widget, const QPoint &pos) {
+    if (widget.windowState() &
+        (Qt::WindowMaximized | Qt::WindowFullScreen)) {
+        return Qt::Edges();
+    }
+    const auto inset = qMax(0, kShadowMargin - kResizeBorderWidth);
+    return resizeEdgesAt(pos - QPoint(inset, inset),
+                         widget.size() - QSize(2 * inset, 2 * inset),
+                         widget.minimumWidth() != widget.maximumWidth(),
+                         widget.minimumHeight() != widget.maximumHeight());
+}
+
+int main(int argc, char *argv[]) {
+    // Hit testing does not depend on the display.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    auto app = QApplication(argc, argv);
+    const auto rounds =
+        argc > 1 ? std::max(1, std::atoi(argv[1])) : 1000;
+
+    auto window = QWidget();
+    window.resize(1280, 800);
+    const auto size = window.size();
+
+    auto map = HitTestMap();
+    map.setFrame(size, kShadowMargin - kResizeBorderWidth, true, true);
+    const auto top = kShadowMargin;
+    const auto width = size.width() - 2 * kShadowMargin;
+    map.setCaption(QRect(kShadowMargin, top, width, 30),
+                   {QRect(kShadowMargin, top, 30, 30),
+                    QRect(kShadowMargin + 30, top, 200, 30),
+                    QRect(kShadowMargin + width - 90, top, 90, 30),
+                    QRect()});
+
+    // A pointer wandering over the whole window, borders and shadow
+    // included, in steps of a few pixels.
+    auto path = std::vector<QPoint>();
+    auto seed = 0x9e3779b9u;
+    auto pos = QPoint(size.width() / 2, size.height() / 2);
+    for (int i = 0; i < 4096; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        pos += QPoint(static_cast<int>(seed >> 28u) - 8,
+                      static_cast<int>((seed >> 24u) & 0xfu) - 8);
+        pos.setX(qBound(0, pos.x(), size.width() - 1));
+        pos.setY(qBound(0, pos.y(), size.height() - 1));
+        path.push_back(pos);
+    }
+    // Every border and corner at least once.
+    for (const auto &corner : {QPoint(9, 9),
+                               QPoint(size.width() - 10, 9),
+                               QPoint(9, size.height() - 10),
+                               QPoint(size.width() - 10, size.height() - 10),
+                               QPoint(size.width() / 2, 9)}) {
+        path.push_back(corner);
+    }
+
+    for (const auto &point : path) {
+        if (map.hitTest(point).edges != recomputedEdges(window, point)) {
+            std::fprintf(stderr,
+                         "map and recomputation disagree at %d,%d\n",
+                         point.x(),
+                         point.y());
+            return 1;
+        }
+    }
+
+    auto checksum = 0u;
+    auto timer = QElapsedTimer();
+    timer.start();
+    for (int round = 0; round < rounds; ++round) {
+        for (const auto &point : path) {
+            checksum += static_cast<unsigned>(
+                recomputedEdges(window, point));
+        }
+    }
+    const auto recomputed = timer.nsecsElapsed();
+
+    timer.restart();
+    for (int round = 0; round < rounds; ++round) {
+        for (const auto &point : path) {
+            const auto hit = map.hitTest(point);
+            checksum += static_cast<unsigned>(hit.edges) +
+                        static_cast<unsigned>(hit.area);
+        }
+    }
+    const auto mapped = timer.nsecsElapsed();
+
+    const auto moves = static_cast<double>(rounds) *
+                       static_cast<double>(path.size());
+    std::printf("%zu moves x %d rounds\n", path.size(), rounds);
+    std::printf("recomputed edges %8.2f ns/move\n",
+                static_cast<double>(recomputed) / moves);
+    std::printf("HitTestMap       %8.2f ns/move (edges and caption)\n",
+                static_cast<double>(mapped) / moves);
+    std::printf("(checksum %x)\n", checksum);
+    return 0;
+}
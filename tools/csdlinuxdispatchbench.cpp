@@ -0,0 +1,116 @@
+// Times how the Linux decoration filter dispatches widget events with 1, 100
+// and 1000 decorated windows: the events it turns away by type or by a flag
+// of the widget, and those it finds the widget's callbacks for.
+
+#include "csdtitlebar.h"
+#include "linuxcsd.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QIcon>
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QWidget>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace CSD;
+using namespace CSD::Internal;
+
+// Events per measurement, spread over all windows.
+static constexpr int kEventsPerRun = 1000000;
+
+struct Decorated {
+    std::unique_ptr<QWidget> window;
+    TitleBar *titleBar;
+};
+
+enum class Target { Window, TitleBar, Undecorated };
+
+static double nanosecondsPerEvent(LinuxClientSideDecorationFilter &filter,
+                                  const std::vector<Decorated> &windows,
+                                  QWidget *undecorated,
+                                  Target target,
+                                  QEvent &event) {
+    const auto count = static_cast<int>(windows.size());
+    const auto rounds = std::max(1, kEventsPerRun / count);
+    auto timer = QElapsedTimer();
+    timer.start();
+    for (int round = 0; round < rounds; ++round) {
+        for (const auto &decorated : windows) {
+            QObject *watched = decorated.window.get();
+            if (target == Target::TitleBar) {
+                watched = decorated.titleBar;
+            } else if (target == Target::Undecorated) {
+                watched = undecorated;
+            }
+            filter.eventFilter(watched, &event);
+        }
+    }
+    return static_cast<double>(timer.nsecsElapsed()) /
+           (static_cast<double>(rounds) * count);
+}
+
+int main(int argc, char *argv[]) {
+    // Dispatch does not depend on the display.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    auto app = QApplication(argc, argv);
+
+    auto mouseMove = QMouseEvent(QEvent::MouseMove,
+                                 QPointF(5, 5),
+                                 Qt::NoButton,
+                                 Qt::NoButton,
+                                 Qt::NoModifier);
+    auto paint = QPaintEvent(QRect(0, 0, 10, 10));
+    auto updateRequest = QEvent(QEvent::UpdateRequest);
+    auto activationChange = QEvent(QEvent::ActivationChange);
+
+    std::printf("%7s  %-26s  %8s\n", "windows", "event", "ns/event");
+    for (const int count : {1, 100, 1000}) {
+        // Declared first to outlive the windows, which unregister
+        // themselves.
+        auto filter = LinuxClientSideDecorationFilter();
+        auto windows = std::vector<Decorated>();
+        windows.reserve(static_cast<std::size_t>(count));
+        for (int i = 0; i < count; ++i) {
+            auto window = std::make_unique<QWidget>();
+            auto *titleBar = new TitleBar(
+                CaptionButtonStyle::custom, QIcon(), window.get());
+            filter.apply(window.get(), titleBar);
+            windows.push_back({std::move(window), titleBar});
+        }
+        auto undecorated = QWidget();
+
+        const struct {
+            const char *name;
+            Target target;
+            QEvent *event;
+        } runs[] = {
+            {"MouseMove, window", Target::Window, &mouseMove},
+            {"Paint, title bar", Target::TitleBar, &paint},
+            {"Paint, window", Target::Window, &paint},
+            {"UpdateRequest, window", Target::Window, &updateRequest},
+            {"UpdateRequest, undecorated",
+             Target::Undecorated,
+             &updateRequest},
+            {"ActivationChange, window", Target::Window, &activationChange},
+        };
+        for (const auto &run : runs) {
+            std::printf("%7d  %-26s  %8.2f\n",
+                        count,
+                        run.name,
+                        nanosecondsPerEvent(filter,
+                                            windows,
+                                            &undecorated,
+                                            run.target,
+                                            *run.event));
+        }
+    }
+    return 0;
+}
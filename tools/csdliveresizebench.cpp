@@ -0,0 +1,124 @@
+// Sweeps the width of a window with a title bar between 1920 and 3840
+// pixels and back, as an interactive resize would, and reports the time per
+// frame and the title bar area painted per frame. TitleBar and
+// PaintedTitleBar keep their caption buttons static and only paint what a
+// step exposes. "full repaint" repaints the whole TitleBar and its buttons
+// on every step, as it did before.
+
+#include "csdpaintedtitlebar.h"
+#include "csdtitlebar.h"
+
+#include <QApplication>
+#include <QBoxLayout>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QPaintEvent>
+#include <QWidget>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace CSD;
+
+static constexpr int kMinWidth = 1920;
+static constexpr int kMaxWidth = 3840;
+static constexpr int kHeight = 400;
+
+namespace {
+
+// Adds up the area of the paint events of a widget and its children.
+class PaintCounter : public QObject {
+public:
+    explicit PaintCounter(QWidget *root) : m_root(root) {}
+
+    qint64 pixels() const {
+        return this->m_pixels;
+    }
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override {
+        if (event->type() != QEvent::Paint || !watched->isWidgetType()) {
+            return false;
+        }
+        auto *widget = static_cast<QWidget *>(watched);
+        if (widget != this->m_root && !this->m_root->isAncestorOf(widget)) {
+            return false;
+        }
+        for (const auto &rect : static_cast<QPaintEvent *>(event)->region()) {
+            this->m_pixels +=
+                static_cast<qint64>(rect.width()) * rect.height();
+        }
+        return false;
+    }
+
+private:
+    QWidget *m_root;
+    qint64 m_pixels = 0;
+};
+
+} // namespace
+
+template <typename T>
+static void sweep(const char *name, int step, bool fullRepaint) {
+    auto window = QWidget();
+    auto *layout = new QVBoxLayout(&window);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
+    auto *titleBar = new T(CaptionButtonStyle::custom, QIcon(), &window);
+    layout->addWidget(titleBar);
+    layout->addStretch(1);
+    window.resize(kMinWidth, kHeight);
+    window.show();
+    QApplication::processEvents();
+
+    const auto children = titleBar->template findChildren<QWidget *>();
+    auto counter = PaintCounter(titleBar);
+    qApp->installEventFilter(&counter);
+    auto frames = 0;
+    auto timer = QElapsedTimer();
+    timer.start();
+    for (const int direction : {1, -1}) {
+        const auto first = direction > 0 ? kMinWidth + step : kMaxWidth - step;
+        for (int width = first; width >= kMinWidth && width <= kMaxWidth;
+             width += direction * step) {
+            window.resize(width, kHeight);
+            if (fullRepaint) {
+                titleBar->update();
+                for (auto *child : children) {
+                    child->update();
+                }
+            }
+            // Delivers the update request, and with it the frame's paint.
+            QApplication::processEvents();
+            ++frames;
+        }
+    }
+    const auto elapsed = timer.nsecsElapsed();
+    qApp->removeEventFilter(&counter);
+
+    std::printf("%-18s  %6d  %9.3f  %12lld\n",
+                name,
+                frames,
+                static_cast<double>(elapsed) / frames / 1000000.0,
+                static_cast<long long>(counter.pixels() / frames));
+}
+
+int main(int argc, char *argv[]) {
+    // Resizing and painting do not depend on the display.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    auto app = QApplication(argc, argv);
+    const auto step = argc > 1 ? std::max(1, std::atoi(argv[1])) : 8;
+
+    std::printf("%-18s  %6s  %9s  %12s\n",
+                "title bar",
+                "frames",
+                "ms/frame",
+                "px/frame");
+    sweep<TitleBar>("full repaint", step, true);
+    sweep<TitleBar>("TitleBar", step, false);
+    sweep<PaintedTitleBar>("PaintedTitleBar", step, false);
+    return 0;
+}
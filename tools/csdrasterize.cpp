@@ -0,0 +1,189 @@
+// Rasterizes every caption icon of the enabled caption styles at the
+// scales in kCaptionAssetScales and writes them as a C++ source holding the
+// bundle described in csdcaptionassets.h.
+
+#include "csdcaptionassets.h"
+#include "csdcaptionicons.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QImageReader>
+#include <QPainter>
+#include <QSvgRenderer>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace CSD;
+using namespace CSD::Internal;
+
+static QImage rasterize(const QString &path, QSize logicalSize, int scale) {
+    const auto factor = scale / 100.0;
+    const auto box =
+        QSize(static_cast<int>(std::lround(logicalSize.width() * factor)),
+              static_cast<int>(std::lround(logicalSize.height() * factor)));
+
+    if (path.endsWith(QLatin1String(".svg"))) {
+        auto renderer = QSvgRenderer(path);
+        if (!renderer.isValid()) {
+            return QImage();
+        }
+        auto image =
+            QImage(renderer.defaultSize().scaled(box, Qt::KeepAspectRatio),
+                   QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        auto painter = QPainter(&image);
+        renderer.render(&painter);
+        return image;
+    }
+
+    auto sourcePath = path;
+    if (scale > 100) {
+        auto highDpiPath = path;
+        highDpiPath.insert(highDpiPath.size() - 4, QLatin1String("@2x"));
+        if (QFile::exists(highDpiPath)) {
+            sourcePath = std::move(highDpiPath);
+        }
+    }
+    auto reader = QImageReader(sourcePath);
+    reader.setScaledSize(reader.size().scaled(box, Qt::KeepAspectRatio));
+    return reader.read().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+static void padTo16(QByteArray &buffer) {
+    while (buffer.size() % 16 != 0) {
+        buffer.append('\0');
+    }
+}
+
+int main(int argc, char *argv[]) {
+    auto app = QCoreApplication(argc, argv);
+    if (argc != 3) {
+        std::fprintf(stderr, "usage: %s <source dir> <output.cpp>\n", argv[0]);
+        return 1;
+    }
+    const auto sourceDir = QString::fromLocal8Bit(argv[1]);
+
+    struct Image {
+        quint16 width;
+        quint16 height;
+        quint32 offset;
+        quint16 format;
+        quint16 bytesPerLine;
+    };
+    auto images = QHash<QString, Image>();
+    auto entries = std::vector<CaptionAssetEntry>();
+    auto pixels = QByteArray();
+
+    for (auto style : {CaptionButtonStyle::custom,
+                       CaptionButtonStyle::win,
+                       CaptionButtonStyle::mac}) {
+        if (captionStyleInfo(style).icons == nullptr) {
+            continue;
+        }
+        for (quint32 states = 0; states < kCaptionButtonStateCount;
+             ++states) {
+            for (quint32 role = 1; role <= 3; ++role) {
+                const auto icon = captionIcon(
+                    style,
+                    role - 1,
+                    CaptionButtonStates(QFlag(static_cast<int>(states))));
+                const bool isMask = icon.tone != CaptionGlyphTone::None;
+                // Resource paths start with ":/", the files live in the tree.
+                const auto path =
+                    sourceDir + icon.path.view().mid(1).toString();
+                for (int scale : kCaptionAssetScales) {
+                    const auto imageKey = path + QLatin1Char('@') +
+                                          QString::number(scale) +
+                                          (isMask ? QLatin1String(":mask")
+                                                  : QLatin1String());
+                    auto it = images.find(imageKey);
+                    if (it == images.end()) {
+                        auto image = rasterize(
+                            path, captionIconSize(style), scale);
+                        if (isMask) {
+                            image =
+                                image.convertToFormat(QImage::Format_Alpha8);
+                        }
+                        if (image.isNull()) {
+                            std::fprintf(stderr,
+                                         "csdrasterize: cannot render %s\n",
+                                         qPrintable(path));
+                            return 1;
+                        }
+                        const auto offset =
+                            static_cast<quint32>(pixels.size());
+                        for (int y = 0; y < image.height(); ++y) {
+                            pixels.append(
+                                reinterpret_cast<const char *>(
+                                    image.constScanLine(y)),
+                                image.bytesPerLine());
+                        }
+                        padTo16(pixels);
+                        it = images.insert(
+                            imageKey,
+                            Image{static_cast<quint16>(image.width()),
+                                  static_cast<quint16>(image.height()),
+                                  offset,
+                                  static_cast<quint16>(image.format()),
+                                  static_cast<quint16>(image.bytesPerLine())});
+                    }
+                    entries.push_back(CaptionAssetEntry{
+                        captionAssetKey(style,
+                                        role,
+                                        states,
+                                        static_cast<quint32>(scale)),
+                        it->width,
+                        it->height,
+                        it->offset,
+                        it->format,
+                        it->bytesPerLine});
+                }
+            }
+        }
+    }
+
+    std::sort(entries.begin(),
+              entries.end(),
+              [](const CaptionAssetEntry &lhs, const CaptionAssetEntry &rhs) {
+                  return lhs.key < rhs.key;
+              });
+
+    auto bundle = QByteArray();
+    auto header = CaptionAssetHeader{kCaptionAssetMagic,
+                                     kCaptionAssetVersion,
+                                     static_cast<quint32>(entries.size()),
+                                     0};
+    const auto tableSize =
+        static_cast<int>(entries.size() * sizeof(CaptionAssetEntry));
+    header.dataOffset = static_cast<quint32>(
+        (static_cast<int>(sizeof(header)) + tableSize + 15) & ~15);
+    bundle.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    bundle.append(reinterpret_cast<const char *>(entries.data()), tableSize);
+    padTo16(bundle);
+    bundle.append(pixels);
+
+    auto output = QFile(QString::fromLocal8Bit(argv[2]));
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::fprintf(stderr, "csdrasterize: cannot write %s\n", argv[2]);
+        return 1;
+    }
+    output.write("// Generated by csdrasterize, do not edit.\n"
+                 "#include <cstddef>\n\n"
+                 "namespace CSD::Internal {\n\n"
+                 "alignas(16) extern const unsigned char "
+                 "captionAssetData[] = {\n");
+    for (int i = 0; i < bundle.size(); ++i) {
+        output.write(QByteArray::number(static_cast<uchar>(bundle[i])));
+        output.write(i % 24 == 23 ? ",\n" : ",");
+    }
+    output.write("};\n"
+                 "extern const std::size_t captionAssetSize = "
+                 "sizeof(captionAssetData);\n\n"
+                 "} // namespace CSD::Internal\n");
+    return 0;
+}
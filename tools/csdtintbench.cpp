@@ -0,0 +1,78 @@
+// Times the tint kernels in csdtint.cpp on caption sized masks, 16 to 48
+// pixels square, and checks that the vector kernels match the scalar one.
+
+#include "csdtint.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace CSD::Internal;
+
+struct Kernel {
+    TintKernel kernel;
+    const char *name;
+};
+
+static constexpr Kernel kKernels[] = {
+    {TintKernel::Scalar, "scalar"},
+    {TintKernel::Sse2, "sse2"},
+    {TintKernel::Avx2, "avx2"},
+};
+
+// Antialiased edges and solid runs, roughly what a rasterized glyph holds.
+static QImage makeMask(int size) {
+    auto mask = QImage(size, size, QImage::Format_Alpha8);
+    for (int y = 0; y < size; ++y) {
+        auto *line = mask.scanLine(y);
+        for (int x = 0; x < size; ++x) {
+            line[x] = static_cast<uchar>((x * 37 + y * 91) & 0xff);
+        }
+    }
+    return mask;
+}
+
+int main(int argc, char *argv[]) {
+    const auto rounds = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20000;
+    const auto color = qRgba(0x20, 0x80, 0xe0, 0xc0);
+
+    std::printf("size  kernel   ns/image   Mpixel/s\n");
+    for (int size = 16; size <= 48; size += 8) {
+        const auto mask = makeMask(size);
+        auto reference =
+            QImage(mask.size(), QImage::Format_ARGB32_Premultiplied);
+        tintAlphaMask(mask, color, reference, TintKernel::Scalar);
+
+        for (const auto &kernel : kKernels) {
+            auto dst =
+                QImage(mask.size(), QImage::Format_ARGB32_Premultiplied);
+            if (!tintAlphaMask(mask, color, dst, kernel.kernel)) {
+                std::printf("%4d  %-7s  unavailable\n", size, kernel.name);
+                continue;
+            }
+            if (dst != reference) {
+                std::fprintf(stderr,
+                             "%s differs from scalar at %dpx\n",
+                             kernel.name,
+                             size);
+                return 1;
+            }
+
+            auto timer = QElapsedTimer();
+            timer.start();
+            for (int round = 0; round < rounds; ++round) {
+                tintAlphaMask(mask, color, dst, kernel.kernel);
+            }
+            const auto nanoseconds =
+                static_cast<double>(timer.nsecsElapsed()) / rounds;
+            std::printf("%4d  %-7s  %8.1f  %9.1f\n",
+                        size,
+                        kernel.name,
+                        nanoseconds,
+                        size * size / nanoseconds * 1000.0);
+        }
+    }
+    return 0;
+}
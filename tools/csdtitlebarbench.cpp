@@ -0,0 +1,118 @@
+// Compares TitleBar, a layout of caption button widgets, with
+// PaintedTitleBar, a single widget: construction time, QObjects and heap
+// per title bar, and the time to paint one at 1280 by 30.
+
+#include "csdpaintedtitlebar.h"
+#include "csdtitlebar.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QWidget>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace CSD;
+
+// Title bars per construction run, each in its own window.
+static constexpr int kTitleBars = 200;
+
+// Bytes in use on the heap, or -1 where that cannot be read.
+static long long heapInUse() {
+#ifdef __GLIBC__
+#if __GLIBC_PREREQ(2, 33)
+    return static_cast<long long>(mallinfo2().uordblks);
+#endif
+#endif
+    return -1;
+}
+
+struct Result {
+    double constructMicroseconds;
+    int objects;
+    long long heapBytes;
+    double paintMicroseconds;
+};
+
+template <typename T> static Result measure(int paints) {
+    auto windows = std::vector<std::unique_ptr<QWidget>>();
+    for (int i = 0; i < kTitleBars; ++i) {
+        windows.push_back(std::make_unique<QWidget>());
+    }
+    auto titleBars = std::vector<T *>();
+    titleBars.reserve(kTitleBars);
+
+    const auto heapBefore = heapInUse();
+    auto timer = QElapsedTimer();
+    timer.start();
+    for (const auto &window : windows) {
+        auto *titleBar =
+            new T(CaptionButtonStyle::custom, QIcon(), window.get());
+        titleBar->resize(1280, 30);
+        titleBar->ensurePolished();
+        titleBars.push_back(titleBar);
+    }
+    const auto constructed = timer.nsecsElapsed();
+    const auto heapAfter = heapInUse();
+
+    // Children are only painted once their window has been shown.
+    auto *titleBar = titleBars.front();
+    titleBar->window()->show();
+    QApplication::processEvents();
+    auto image = QImage(titleBar->size(), QImage::Format_ARGB32_Premultiplied);
+    // Warms the caption icon cache.
+    titleBar->render(&image);
+    timer.restart();
+    for (int i = 0; i < paints; ++i) {
+        titleBar->setActive(i % 2 == 0);
+        titleBar->render(&image);
+    }
+    const auto painted = timer.nsecsElapsed();
+
+    auto result = Result();
+    result.constructMicroseconds =
+        static_cast<double>(constructed) / kTitleBars / 1000.0;
+    result.objects =
+        1 + static_cast<int>(titleBar->template findChildren<QObject *>()
+                                 .size());
+    result.heapBytes = heapBefore < 0 ? -1
+                                      : (heapAfter - heapBefore) / kTitleBars;
+    result.paintMicroseconds = static_cast<double>(painted) / paints / 1000.0;
+    return result;
+}
+
+static void print(const char *name, const Result &result) {
+    std::printf("%-16s  %12.2f  %7d  %10lld  %10.2f\n",
+                name,
+                result.constructMicroseconds,
+                result.objects,
+                result.heapBytes,
+                result.paintMicroseconds);
+}
+
+int main(int argc, char *argv[]) {
+    // Painting into an image does not depend on the display.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    auto app = QApplication(argc, argv);
+    const auto paints = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+
+    std::printf("%-16s  %12s  %7s  %10s  %10s\n",
+                "title bar",
+                "construct us",
+                "objects",
+                "heap bytes",
+                "paint us");
+    print("TitleBar", measure<TitleBar>(paints));
+    print("PaintedTitleBar", measure<PaintedTitleBar>(paints));
+    return 0;
+}
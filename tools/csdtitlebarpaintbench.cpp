@@ -0,0 +1,93 @@
+// Times painting a TitleBar at 1280 by 30 under Fusion, without and with an
+// application style sheet that styles the title bar. Without one the title
+// bar and its caption buttons fill their backgrounds directly; with one they
+// go through QStyle. Each mode is compared with a widget that paints its
+// background the way the title bar used to, auto-filled and then drawn
+// again through PE_Widget.
+
+#include "csdtitlebar.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QPainter>
+#include <QStyle>
+#include <QStyleOption>
+#include <QWidget>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace CSD;
+
+namespace {
+
+class LegacyBackground : public QWidget {
+public:
+    LegacyBackground() {
+        this->setObjectName("LegacyBackground");
+        this->setAutoFillBackground(true);
+    }
+
+protected:
+    void paintEvent([[maybe_unused]] QPaintEvent *event) override {
+        auto styleOption = QStyleOption();
+        styleOption.init(this);
+        auto painter = QPainter(this);
+        this->style()->drawPrimitive(
+            QStyle::PE_Widget, &styleOption, &painter, this);
+    }
+};
+
+} // namespace
+
+static double microsecondsPerPaint(QWidget &widget, int paints) {
+    widget.resize(1280, 30);
+    widget.show();
+    QApplication::processEvents();
+    auto image = QImage(widget.size(), QImage::Format_ARGB32_Premultiplied);
+    // Warms the caption icon cache and the style sheet rules.
+    widget.render(&image);
+    auto timer = QElapsedTimer();
+    timer.start();
+    for (int i = 0; i < paints; ++i) {
+        widget.render(&image);
+    }
+    return static_cast<double>(timer.nsecsElapsed()) / paints / 1000.0;
+}
+
+int main(int argc, char *argv[]) {
+    // Painting into an image does not depend on the display.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    auto app = QApplication(argc, argv);
+    QApplication::setStyle("Fusion");
+    const auto paints = argc > 1 ? std::max(1, std::atoi(argv[1])) : 5000;
+
+    const struct {
+        const char *name;
+        const char *styleSheet;
+    } modes[] = {
+        {"Fusion", ""},
+        {"Fusion, style sheet",
+         "CSD--TitleBar, #LegacyBackground { background: #202020; }"},
+    };
+    std::printf("%-20s  %-18s  %8s\n", "style", "widget", "us/paint");
+    for (const auto &mode : modes) {
+        app.setStyleSheet(mode.styleSheet);
+        // Created after the style sheet, so they are polished with it.
+        auto titleBar = TitleBar(CaptionButtonStyle::custom);
+        auto legacy = LegacyBackground();
+        std::printf("%-20s  %-18s  %8.2f\n",
+                    mode.name,
+                    "TitleBar",
+                    microsecondsPerPaint(titleBar, paints));
+        std::printf("%-20s  %-18s  %8.2f\n",
+                    mode.name,
+                    "old background",
+                    microsecondsPerPaint(legacy, paints));
+    }
+    return 0;
+}
@@ -0,0 +1,431 @@
+// Replays a trace of Win32 messages through the Win32 decoration filter
+// against RecordingWin32Api and reports, per message, the time the filter
+// took, the Win32 calls it made and how often it set the window's custom
+// margins. Traces are recorded on Windows by running an application with
+// CSD_WIN32_TRACE naming the file to write, or synthesized here for a
+// drag-and-resize session.
+
+#include "csdtitlebar.h"
+#include "win32apifake.h"
+#include "win32csd.h"
+#include "win32trace.h"
+
+#include <QApplication>
+#include <QBoxLayout>
+#include <QDynamicPropertyChangeEvent>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QWidget>
+#include <QWindow>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+using namespace CSD;
+using namespace CSD::Internal;
+
+// Pointer moves come at 125 Hz.
+static constexpr qint64 kPointerInterval = 8000;
+// SM_CYCAPTION at 96 and at 120 DPI. Traces do not record the system
+// metrics, so each settings, theme or DPI change replayed switches between
+// the two, changing the custom margins.
+static constexpr int kCaptionHeights[] = {23, 29};
+
+namespace {
+
+// Counts how often the filter sets the custom margins on a window.
+class MarginPushCounter : public QObject {
+public:
+    quint64 pushes() const {
+        return this->m_pushes;
+    }
+
+protected:
+    bool eventFilter([[maybe_unused]] QObject *watched,
+                     QEvent *event) override {
+        if (event->type() == QEvent::DynamicPropertyChange &&
+            static_cast<QDynamicPropertyChangeEvent *>(event)
+                    ->propertyName() == "_q_windowsCustomMargins") {
+            ++this->m_pushes;
+        }
+        return false;
+    }
+
+private:
+    quint64 m_pushes = 0;
+};
+
+} // namespace
+
+static bool isMetricsChange(UINT message) {
+    return message == WM_SETTINGCHANGE || message == WM_THEMECHANGED ||
+           message == WM_DPICHANGED;
+}
+
+static const char *messageName(UINT message) {
+    switch (message) {
+    case WM_CREATE:
+        return "WM_CREATE";
+    case WM_SIZE:
+        return "WM_SIZE";
+    case WM_ACTIVATE:
+        return "WM_ACTIVATE";
+    case WM_SETTINGCHANGE:
+        return "WM_SETTINGCHANGE";
+    case WM_GETMINMAXINFO:
+        return "WM_GETMINMAXINFO";
+    case WM_WINDOWPOSCHANGED:
+        return "WM_WINDOWPOSCHANGED";
+    case WM_NCCALCSIZE:
+        return "WM_NCCALCSIZE";
+    case WM_NCHITTEST:
+        return "WM_NCHITTEST";
+    case WM_NCACTIVATE:
+        return "WM_NCACTIVATE";
+    case WM_NCMOUSEMOVE:
+        return "WM_NCMOUSEMOVE";
+    case WM_NCLBUTTONDOWN:
+        return "WM_NCLBUTTONDOWN";
+    case WM_MOUSEMOVE:
+        return "WM_MOUSEMOVE";
+    case WM_SIZING:
+        return "WM_SIZING";
+    case WM_MOVING:
+        return "WM_MOVING";
+    case WM_ENTERSIZEMOVE:
+        return "WM_ENTERSIZEMOVE";
+    case WM_EXITSIZEMOVE:
+        return "WM_EXITSIZEMOVE";
+    case WM_DPICHANGED:
+        return "WM_DPICHANGED";
+    case WM_THEMECHANGED:
+        return "WM_THEMECHANGED";
+    default:
+        return nullptr;
+    }
+}
+
+static LPARAM pointLParam(LONG x, LONG y) {
+    return static_cast<LPARAM>((static_cast<quint32>(y) & 0xffff) << 16 |
+                               (static_cast<quint32>(x) & 0xffff));
+}
+
+// A session of the given length: the pointer crosses the caption, drags the
+// window, resizes it by its bottom right corner, maximizes it, the system
+// settings and theme change, and the window is deactivated and activated
+// again.
+static std::vector<Win32TraceEntry> synthesize(qint64 seconds) {
+    auto entries = std::vector<Win32TraceEntry>();
+    auto time = qint64(0);
+    auto rect = RECT{200, 150, 1000, 750};
+    auto showCmd = UINT(SW_SHOWNORMAL);
+    const auto add = [&](UINT message, WPARAM wParam, LPARAM lParam) {
+        entries.push_back({time, message, wParam, lParam, rect, showCmd});
+    };
+    const auto ticks = std::max<qint64>(seconds * 1000000 / kPointerInterval,
+                                        8);
+
+    add(WM_CREATE, 0, 0);
+    add(WM_ACTIVATE, WA_ACTIVE, 0);
+    add(WM_NCACTIVATE, TRUE, 0);
+
+    // The pointer sweeps across the caption for the first quarter.
+    const auto hover = ticks / 4;
+    const auto width = qint64(rect.right - rect.left);
+    for (auto tick = qint64(0); tick < hover;
+         ++tick, time += kPointerInterval) {
+        const auto x = rect.left + static_cast<LONG>(tick * width / hover);
+        add(WM_NCHITTEST, 0, pointLParam(x, rect.top + 12));
+        add(WM_NCMOUSEMOVE, HTCAPTION, pointLParam(x, rect.top + 12));
+    }
+
+    // Then drags the window by it for the second.
+    add(WM_NCLBUTTONDOWN,
+        HTCAPTION,
+        pointLParam(rect.left + 100, rect.top + 12));
+    add(WM_ENTERSIZEMOVE, 0, 0);
+    const auto drag = ticks / 4;
+    for (auto tick = qint64(0); tick < drag;
+         ++tick, time += kPointerInterval) {
+        rect.left += 2;
+        rect.right += 2;
+        rect.top += 1;
+        rect.bottom += 1;
+        add(WM_MOVING, 0, 0);
+        add(WM_WINDOWPOSCHANGED, 0, 0);
+        add(WM_NCHITTEST, 0, pointLParam(rect.left + 100, rect.top + 12));
+    }
+    add(WM_EXITSIZEMOVE, 0, 0);
+
+    // Resizes it by its bottom right corner for most of the rest.
+    add(WM_NCHITTEST, 0, pointLParam(rect.right - 2, rect.bottom - 2));
+    add(WM_NCLBUTTONDOWN,
+        HTBOTTOMRIGHT,
+        pointLParam(rect.right - 2, rect.bottom - 2));
+    add(WM_ENTERSIZEMOVE, 0, 0);
+    const auto resize = ticks * 3 / 8;
+    for (auto tick = qint64(0); tick < resize;
+         ++tick, time += kPointerInterval) {
+        rect.right += tick < resize / 2 ? 2 : -2;
+        rect.bottom += tick < resize / 2 ? 1 : -1;
+        add(WM_SIZING, 8, 0);
+        add(WM_NCCALCSIZE, TRUE, 0);
+        add(WM_SIZE, 0, 0);
+        add(WM_WINDOWPOSCHANGED, 0, 0);
+        add(WM_NCHITTEST, 0, pointLParam(rect.right - 2, rect.bottom - 2));
+    }
+    add(WM_EXITSIZEMOVE, 0, 0);
+
+    // Maximizes it, and is away and back. Windows puts the frame of a
+    // maximized window past the work area.
+    showCmd = SW_MAXIMIZE;
+    rect = RECT{-8, -8, 1928, 1048};
+    add(WM_GETMINMAXINFO, 0, 0);
+    add(WM_NCCALCSIZE, TRUE, 0);
+    add(WM_SIZE, 2, 0);
+    add(WM_WINDOWPOSCHANGED, 0, 0);
+    time += kPointerInterval;
+    add(WM_SETTINGCHANGE, 0, 0);
+    add(WM_THEMECHANGED, 0, 0);
+    time += kPointerInterval;
+    add(WM_NCACTIVATE, FALSE, 0);
+    add(WM_ACTIVATE, WA_INACTIVE, 0);
+    time += kPointerInterval;
+    add(WM_NCACTIVATE, TRUE, 0);
+    add(WM_ACTIVATE, WA_ACTIVE, 0);
+    for (auto tick = qint64(0); tick < ticks / 8;
+         ++tick, time += kPointerInterval) {
+        add(WM_NCHITTEST, 0, pointLParam(960, 12));
+    }
+    return entries;
+}
+
+static bool readTrace(const char *path,
+                      std::vector<Win32TraceEntry> &entries) {
+    auto file = QFile(QString::fromLocal8Bit(path));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    while (!file.atEnd()) {
+        const auto entry = parseWin32TraceEntry(file.readLine());
+        if (entry) {
+            entries.push_back(*entry);
+        }
+    }
+    return true;
+}
+
+static bool writeTrace(const char *path,
+                       const std::vector<Win32TraceEntry> &entries) {
+    auto file = QFile(QString::fromLocal8Bit(path));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    file.write("# time message wParam lParam left top right bottom showCmd\n");
+    for (const auto &entry : entries) {
+        file.write(formatWin32TraceEntry(entry));
+    }
+    return true;
+}
+
+static int usage(const char *program) {
+    std::fprintf(stderr,
+                 "usage: %s [--repeat <n>] [--max-calls <n>] <trace>\n"
+                 "       %s --synthesize <seconds> <trace>\n"
+                 "--max-calls fails when a message makes more Win32 calls "
+                 "on average.\n",
+                 program,
+                 program);
+    return 2;
+}
+
+struct MessageStats {
+    quint64 count = 0;
+    qint64 totalNanoseconds = 0;
+    qint64 maxNanoseconds = 0;
+    quint64 calls = 0;
+    quint64 pushes = 0;
+};
+
+// Prints a row of the report and returns the calls per message.
+static double printStats(const char *name, const MessageStats &stats) {
+    const auto count = static_cast<double>(stats.count);
+    const auto callsPerMessage = static_cast<double>(stats.calls) / count;
+    std::printf("%-22s %9llu %10.0f %10lld %10.2f %7llu\n",
+                name,
+                static_cast<unsigned long long>(stats.count),
+                static_cast<double>(stats.totalNanoseconds) / count,
+                static_cast<long long>(stats.maxNanoseconds),
+                callsPerMessage,
+                static_cast<unsigned long long>(stats.pushes));
+    return callsPerMessage;
+}
+
+int main(int argc, char *argv[]) {
+    auto repeat = 1;
+    auto maxCalls = -1.0;
+    auto synthesizeSeconds = qint64(-1);
+    const char *tracePath = nullptr;
+    for (auto i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--max-calls") == 0 && i + 1 < argc) {
+            maxCalls = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--synthesize") == 0 &&
+                   i + 1 < argc) {
+            synthesizeSeconds = std::atoll(argv[++i]);
+        } else if (tracePath == nullptr && argv[i][0] != '-') {
+            tracePath = argv[i];
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (tracePath == nullptr) {
+        return usage(argv[0]);
+    }
+
+    if (synthesizeSeconds >= 0) {
+        if (!writeTrace(tracePath, synthesize(synthesizeSeconds))) {
+            std::fprintf(stderr, "cannot write %s\n", tracePath);
+            return 1;
+        }
+        return 0;
+    }
+
+    auto entries = std::vector<Win32TraceEntry>();
+    if (!readTrace(tracePath, entries) || entries.empty()) {
+        std::fprintf(stderr, "cannot read a trace from %s\n", tracePath);
+        return 1;
+    }
+
+    // No display is needed to replay.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    auto app = QApplication(argc, argv);
+    auto api = RecordingWin32Api();
+    setWin32Api(&api);
+
+    // Declared first to outlive the window, which unregisters itself.
+    auto filter = Win32ClientSideDecorationFilter();
+    auto window = QWidget();
+    window.setWindowFlag(Qt::FramelessWindowHint);
+    auto *layout = new QVBoxLayout(&window);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
+    auto *titleBar = new TitleBar(CaptionButtonStyle::win, QIcon(), &window);
+    layout->addWidget(titleBar);
+    layout->addStretch();
+
+    filter.apply(&window, titleBar);
+    const auto &first = entries.front().windowRect;
+    window.resize(first.right - first.left, first.bottom - first.top);
+    window.show();
+    QApplication::processEvents();
+    auto pushCounter = MarginPushCounter();
+    window.windowHandle()->installEventFilter(&pushCounter);
+
+    const auto eventType = QByteArrayLiteral("windows_generic_MSG");
+    const auto hwnd = reinterpret_cast<HWND>(window.winId());
+    const auto dpr = window.devicePixelRatioF();
+    auto stats = std::map<UINT, MessageStats>();
+    // The window's resizes between messages, where the widget event filter
+    // does its part.
+    auto resizeStats = MessageStats();
+    api.resetCalls();
+    auto metricsChanges = 0;
+    auto timer = QElapsedTimer();
+    for (auto pass = 0; pass < repeat; ++pass) {
+        for (const auto &entry : entries) {
+            api.setWindowRect(entry.windowRect);
+            api.setShowCmd(entry.showCmd);
+            // What the window would have been told before the message.
+            const auto size =
+                QSize(qRound((entry.windowRect.right - entry.windowRect.left) /
+                             dpr),
+                      qRound((entry.windowRect.bottom - entry.windowRect.top) /
+                             dpr));
+            if (size != window.size()) {
+                const auto callsBefore = api.totalCalls();
+                const auto pushesBefore = pushCounter.pushes();
+                timer.start();
+                window.resize(size);
+                QApplication::processEvents();
+                const auto elapsed = timer.nsecsElapsed();
+                ++resizeStats.count;
+                resizeStats.totalNanoseconds += elapsed;
+                resizeStats.maxNanoseconds =
+                    std::max(resizeStats.maxNanoseconds, elapsed);
+                resizeStats.calls += api.totalCalls() - callsBefore;
+                resizeStats.pushes += pushCounter.pushes() - pushesBefore;
+            }
+            if (isMetricsChange(entry.message)) {
+                ++metricsChanges;
+                api.setCaptionHeight(kCaptionHeights[metricsChanges % 2]);
+            }
+
+            auto msg = MSG();
+            msg.hwnd = hwnd;
+            msg.message = entry.message;
+            msg.wParam = entry.wParam;
+            msg.lParam = entry.lParam;
+            auto calcSizeParams = NCCALCSIZE_PARAMS();
+            if (entry.message == WM_NCCALCSIZE) {
+                calcSizeParams.rgrc[0] = entry.windowRect;
+                msg.lParam = reinterpret_cast<LPARAM>(&calcSizeParams);
+            }
+
+            const auto callsBefore = api.totalCalls();
+            const auto pushesBefore = pushCounter.pushes();
+            long result = 0;
+            timer.start();
+            filter.nativeEventFilter(eventType, &msg, &result);
+            const auto elapsed = timer.nsecsElapsed();
+
+            auto &messageStats = stats[entry.message];
+            ++messageStats.count;
+            messageStats.totalNanoseconds += elapsed;
+            messageStats.maxNanoseconds =
+                std::max(messageStats.maxNanoseconds, elapsed);
+            messageStats.calls += api.totalCalls() - callsBefore;
+            messageStats.pushes += pushCounter.pushes() - pushesBefore;
+        }
+    }
+
+    std::printf("%-22s %9s %10s %10s %10s %7s\n",
+                "message",
+                "count",
+                "mean ns",
+                "max ns",
+                "calls/msg",
+                "pushes");
+    auto failed = false;
+    for (const auto &[message, messageStats] : stats) {
+        const auto *name = messageName(message);
+        const auto unnamed =
+            QByteArray("0x") + QByteArray::number(message, 16);
+        const auto callsPerMessage = printStats(
+            name != nullptr ? name : unnamed.constData(), messageStats);
+        if (maxCalls >= 0 && callsPerMessage > maxCalls) {
+            failed = true;
+        }
+    }
+    if (resizeStats.count > 0) {
+        printStats("(resize)", resizeStats);
+    }
+    std::printf("\n%-30s %10s\n", "function", "calls");
+    for (auto call = 0; call < static_cast<int>(Win32Call::Count); ++call) {
+        const auto calls = api.calls(static_cast<Win32Call>(call));
+        if (calls > 0) {
+            std::printf("%-30s %10llu\n",
+                        win32CallName(static_cast<Win32Call>(call)),
+                        static_cast<unsigned long long>(calls));
+        }
+    }
+    setWin32Api(nullptr);
+    return failed ? 1 : 0;
+}
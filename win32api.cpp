@@ -0,0 +1,110 @@
+#include "win32api.h"
+
+#ifndef _WIN32
+#include "win32apifake.h"
+#endif
+
+namespace CSD::Internal {
+
+#ifdef _WIN32
+namespace {
+
+class SystemWin32Api final : public Win32Api {
+public:
+    BOOL adjustWindowRectEx(RECT *rect,
+                            DWORD style,
+                            BOOL menu,
+                            DWORD exStyle) override {
+        return ::AdjustWindowRectEx(rect, style, menu, exStyle);
+    }
+
+    int getSystemMetrics(int index) override {
+        return ::GetSystemMetrics(index);
+    }
+
+    BOOL getWindowRect(HWND window, RECT *rect) override {
+        return ::GetWindowRect(window, rect);
+    }
+
+    BOOL screenToClient(HWND window, POINT *point) override {
+        return ::ScreenToClient(window, point);
+    }
+
+    BOOL setWindowPos(HWND window,
+                      HWND insertAfter,
+                      int x,
+                      int y,
+                      int width,
+                      int height,
+                      UINT flags) override {
+        return ::SetWindowPos(
+            window, insertAfter, x, y, width, height, flags);
+    }
+
+    BOOL getWindowPlacement(HWND window,
+                            WINDOWPLACEMENT *placement) override {
+        return ::GetWindowPlacement(window, placement);
+    }
+
+    HMONITOR monitorFromWindow(HWND window, DWORD flags) override {
+        return ::MonitorFromWindow(window, flags);
+    }
+
+    BOOL getMonitorInfo(HMONITOR monitor, MONITORINFO *info) override {
+        return ::GetMonitorInfoW(monitor, info);
+    }
+
+    HRESULT dwmExtendFrameIntoClientArea(HWND window,
+                                         const MARGINS *margins) override {
+        return ::DwmExtendFrameIntoClientArea(window, margins);
+    }
+
+    HRESULT dwmIsCompositionEnabled(BOOL *enabled) override {
+        return ::DwmIsCompositionEnabled(enabled);
+    }
+
+    LSTATUS regOpenKeyEx(HKEY key,
+                         LPCWSTR subKey,
+                         DWORD options,
+                         REGSAM access,
+                         HKEY *result) override {
+        return ::RegOpenKeyExW(key, subKey, options, access, result);
+    }
+
+    LSTATUS regQueryValueEx(HKEY key,
+                            LPCWSTR valueName,
+                            DWORD *type,
+                            BYTE *data,
+                            DWORD *dataSize) override {
+        return ::RegQueryValueExW(
+            key, valueName, nullptr, type, data, dataSize);
+    }
+
+    LSTATUS regCloseKey(HKEY key) override {
+        return ::RegCloseKey(key);
+    }
+};
+
+} // namespace
+#endif
+
+static Win32Api *s_api = nullptr;
+
+Win32Api &win32Api() {
+    if (s_api != nullptr) {
+        return *s_api;
+    }
+#ifdef _WIN32
+    static auto systemApi = SystemWin32Api();
+    return systemApi;
+#else
+    static auto recordingApi = RecordingWin32Api();
+    return recordingApi;
+#endif
+}
+
+void setWin32Api(Win32Api *api) {
+    s_api = api;
+}
+
+} // namespace CSD::Internal
@@ -0,0 +1,60 @@
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <dwmapi.h>
+#include <windowsx.h>
+#else
+#include "win32apitypes.h"
+#endif
+
+namespace CSD::Internal {
+
+// The Win32 functions the decoration filter calls, behind one interface so
+// the filter can run against a recording fake on other platforms. Each
+// function mirrors the Windows function of the same name.
+class Win32Api {
+public:
+    virtual ~Win32Api() = default;
+
+    virtual BOOL adjustWindowRectEx(RECT *rect,
+                                    DWORD style,
+                                    BOOL menu,
+                                    DWORD exStyle) = 0;
+    virtual int getSystemMetrics(int index) = 0;
+    virtual BOOL getWindowRect(HWND window, RECT *rect) = 0;
+    virtual BOOL screenToClient(HWND window, POINT *point) = 0;
+    virtual BOOL setWindowPos(HWND window,
+                              HWND insertAfter,
+                              int x,
+                              int y,
+                              int width,
+                              int height,
+                              UINT flags) = 0;
+    virtual BOOL getWindowPlacement(HWND window,
+                                    WINDOWPLACEMENT *placement) = 0;
+    virtual HMONITOR monitorFromWindow(HWND window, DWORD flags) = 0;
+    virtual BOOL getMonitorInfo(HMONITOR monitor, MONITORINFO *info) = 0;
+    virtual HRESULT dwmExtendFrameIntoClientArea(HWND window,
+                                                 const MARGINS *margins) = 0;
+    virtual HRESULT dwmIsCompositionEnabled(BOOL *enabled) = 0;
+    virtual LSTATUS regOpenKeyEx(HKEY key,
+                                 LPCWSTR subKey,
+                                 DWORD options,
+                                 REGSAM access,
+                                 HKEY *result) = 0;
+    virtual LSTATUS regQueryValueEx(HKEY key,
+                                    LPCWSTR valueName,
+                                    DWORD *type,
+                                    BYTE *data,
+                                    DWORD *dataSize) = 0;
+    virtual LSTATUS regCloseKey(HKEY key) = 0;
+};
+
+// The implementation the filter calls: the system's on Windows and a
+// RecordingWin32Api elsewhere, unless replaced.
+Win32Api &win32Api();
+// Replaces it; api must outlive its use, nullptr restores the default.
+void setWin32Api(Win32Api *api);
+
+} // namespace CSD::Internal
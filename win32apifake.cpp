@@ -0,0 +1,216 @@
+#include "win32apifake.h"
+
+#include <cstring>
+
+namespace CSD::Internal {
+
+// What Windows 10 reports at 96 DPI.
+static constexpr int kFrameThickness = 8;
+static constexpr int kSmallIconSize = 16;
+
+const char *win32CallName(Win32Call call) {
+    switch (call) {
+    case Win32Call::AdjustWindowRectEx:
+        return "AdjustWindowRectEx";
+    case Win32Call::GetSystemMetrics:
+        return "GetSystemMetrics";
+    case Win32Call::GetWindowRect:
+        return "GetWindowRect";
+    case Win32Call::ScreenToClient:
+        return "ScreenToClient";
+    case Win32Call::SetWindowPos:
+        return "SetWindowPos";
+    case Win32Call::GetWindowPlacement:
+        return "GetWindowPlacement";
+    case Win32Call::MonitorFromWindow:
+        return "MonitorFromWindow";
+    case Win32Call::GetMonitorInfo:
+        return "GetMonitorInfoW";
+    case Win32Call::DwmExtendFrameIntoClientArea:
+        return "DwmExtendFrameIntoClientArea";
+    case Win32Call::DwmIsCompositionEnabled:
+        return "DwmIsCompositionEnabled";
+    case Win32Call::RegOpenKeyEx:
+        return "RegOpenKeyExW";
+    case Win32Call::RegQueryValueEx:
+        return "RegQueryValueExW";
+    case Win32Call::RegCloseKey:
+        return "RegCloseKey";
+    case Win32Call::Count:
+        break;
+    }
+    return "";
+}
+
+BOOL RecordingWin32Api::adjustWindowRectEx(RECT *rect,
+                                           DWORD style,
+                                           [[maybe_unused]] BOOL menu,
+                                           [[maybe_unused]] DWORD exStyle) {
+    this->record(Win32Call::AdjustWindowRectEx);
+    if (style & WS_THICKFRAME) {
+        rect->left -= kFrameThickness;
+        rect->top -= kFrameThickness;
+        rect->right += kFrameThickness;
+        rect->bottom += kFrameThickness;
+    }
+    return TRUE;
+}
+
+int RecordingWin32Api::getSystemMetrics(int index) {
+    this->record(Win32Call::GetSystemMetrics);
+    switch (index) {
+    case SM_CYCAPTION:
+        return this->m_captionHeight;
+    case SM_CXSMICON:
+        return kSmallIconSize;
+    default:
+        return 0;
+    }
+}
+
+BOOL RecordingWin32Api::getWindowRect([[maybe_unused]] HWND window,
+                                      RECT *rect) {
+    this->record(Win32Call::GetWindowRect);
+    *rect = this->m_windowRect;
+    return TRUE;
+}
+
+BOOL RecordingWin32Api::screenToClient([[maybe_unused]] HWND window,
+                                       POINT *point) {
+    this->record(Win32Call::ScreenToClient);
+    // The filter's WM_NCCALCSIZE makes the whole window the client area, or
+    // the work area while maximized.
+    const auto &client =
+        this->m_showCmd == SW_MAXIMIZE ? this->m_workArea : this->m_windowRect;
+    point->x -= client.left;
+    point->y -= client.top;
+    return TRUE;
+}
+
+BOOL RecordingWin32Api::setWindowPos([[maybe_unused]] HWND window,
+                                     [[maybe_unused]] HWND insertAfter,
+                                     int x,
+                                     int y,
+                                     int width,
+                                     int height,
+                                     [[maybe_unused]] UINT flags) {
+    this->record(Win32Call::SetWindowPos);
+    this->m_windowRect = RECT{x, y, x + width, y + height};
+    return TRUE;
+}
+
+BOOL RecordingWin32Api::getWindowPlacement([[maybe_unused]] HWND window,
+                                           WINDOWPLACEMENT *placement) {
+    this->record(Win32Call::GetWindowPlacement);
+    placement->showCmd = this->m_showCmd;
+    placement->rcNormalPosition = this->m_windowRect;
+    return TRUE;
+}
+
+HMONITOR RecordingWin32Api::monitorFromWindow([[maybe_unused]] HWND window,
+                                              [[maybe_unused]] DWORD flags) {
+    this->record(Win32Call::MonitorFromWindow);
+    // Any handle but null will do, it only comes back to getMonitorInfo().
+    return reinterpret_cast<HMONITOR>(this);
+}
+
+BOOL RecordingWin32Api::getMonitorInfo([[maybe_unused]] HMONITOR monitor,
+                                       MONITORINFO *info) {
+    this->record(Win32Call::GetMonitorInfo);
+    info->rcMonitor = this->m_workArea;
+    info->rcWork = this->m_workArea;
+    info->dwFlags = 1;
+    return TRUE;
+}
+
+HRESULT RecordingWin32Api::dwmExtendFrameIntoClientArea(
+    [[maybe_unused]] HWND window, [[maybe_unused]] const MARGINS *margins) {
+    this->record(Win32Call::DwmExtendFrameIntoClientArea);
+    return S_OK;
+}
+
+HRESULT RecordingWin32Api::dwmIsCompositionEnabled(BOOL *enabled) {
+    this->record(Win32Call::DwmIsCompositionEnabled);
+    *enabled = this->m_compositionEnabled ? TRUE : FALSE;
+    return S_OK;
+}
+
+LSTATUS RecordingWin32Api::regOpenKeyEx([[maybe_unused]] HKEY key,
+                                        [[maybe_unused]] LPCWSTR subKey,
+                                        [[maybe_unused]] DWORD options,
+                                        [[maybe_unused]] REGSAM access,
+                                        HKEY *result) {
+    this->record(Win32Call::RegOpenKeyEx);
+    *result = reinterpret_cast<HKEY>(this);
+    return ERROR_SUCCESS;
+}
+
+LSTATUS RecordingWin32Api::regQueryValueEx([[maybe_unused]] HKEY key,
+                                           [[maybe_unused]] LPCWSTR valueName,
+                                           DWORD *type,
+                                           BYTE *data,
+                                           DWORD *dataSize) {
+    this->record(Win32Call::RegQueryValueEx);
+    // The only value asked for is the DWORD ColorizationColor.
+    if (type != nullptr) {
+        *type = 4; // REG_DWORD
+    }
+    if (data == nullptr || *dataSize < sizeof(DWORD)) {
+        *dataSize = sizeof(DWORD);
+        return data == nullptr ? ERROR_SUCCESS : ERROR_MORE_DATA;
+    }
+    std::memcpy(data, &this->m_colorizationColor, sizeof(DWORD));
+    *dataSize = sizeof(DWORD);
+    return ERROR_SUCCESS;
+}
+
+LSTATUS RecordingWin32Api::regCloseKey([[maybe_unused]] HKEY key) {
+    this->record(Win32Call::RegCloseKey);
+    return ERROR_SUCCESS;
+}
+
+void RecordingWin32Api::setWindowRect(const RECT &rect) {
+    this->m_windowRect = rect;
+}
+
+void RecordingWin32Api::setShowCmd(UINT showCmd) {
+    this->m_showCmd = showCmd;
+}
+
+void RecordingWin32Api::setWorkArea(const RECT &rect) {
+    this->m_workArea = rect;
+}
+
+void RecordingWin32Api::setCaptionHeight(int height) {
+    this->m_captionHeight = height;
+}
+
+void RecordingWin32Api::setCompositionEnabled(bool enabled) {
+    this->m_compositionEnabled = enabled;
+}
+
+void RecordingWin32Api::setColorizationColor(DWORD color) {
+    this->m_colorizationColor = color;
+}
+
+quint64 RecordingWin32Api::calls(Win32Call call) const {
+    return this->m_calls[static_cast<std::size_t>(call)];
+}
+
+quint64 RecordingWin32Api::totalCalls() const {
+    auto total = quint64(0);
+    for (const auto calls : this->m_calls) {
+        total += calls;
+    }
+    return total;
+}
+
+void RecordingWin32Api::resetCalls() {
+    this->m_calls.fill(0);
+}
+
+void RecordingWin32Api::record(Win32Call call) {
+    ++this->m_calls[static_cast<std::size_t>(call)];
+}
+
+} // namespace CSD::Internal
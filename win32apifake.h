@@ -0,0 +1,98 @@
+#pragma once
+
+#include "win32api.h"
+
+#include <QtGlobal>
+
+#include <array>
+#include <cstddef>
+
+namespace CSD::Internal {
+
+enum class Win32Call {
+    AdjustWindowRectEx,
+    GetSystemMetrics,
+    GetWindowRect,
+    ScreenToClient,
+    SetWindowPos,
+    GetWindowPlacement,
+    MonitorFromWindow,
+    GetMonitorInfo,
+    DwmExtendFrameIntoClientArea,
+    DwmIsCompositionEnabled,
+    RegOpenKeyEx,
+    RegQueryValueEx,
+    RegCloseKey,
+    Count
+};
+
+// The name of the Windows function call stands for.
+const char *win32CallName(Win32Call call);
+
+// A Win32Api for running the decoration filter off Windows. It answers from
+// the state set on it, as if every window were the one window described and
+// sat alone on one monitor, and counts the calls made to each function.
+class RecordingWin32Api final : public Win32Api {
+public:
+    BOOL adjustWindowRectEx(RECT *rect,
+                            DWORD style,
+                            BOOL menu,
+                            DWORD exStyle) override;
+    int getSystemMetrics(int index) override;
+    BOOL getWindowRect(HWND window, RECT *rect) override;
+    BOOL screenToClient(HWND window, POINT *point) override;
+    BOOL setWindowPos(HWND window,
+                      HWND insertAfter,
+                      int x,
+                      int y,
+                      int width,
+                      int height,
+                      UINT flags) override;
+    BOOL getWindowPlacement(HWND window,
+                            WINDOWPLACEMENT *placement) override;
+    HMONITOR monitorFromWindow(HWND window, DWORD flags) override;
+    BOOL getMonitorInfo(HMONITOR monitor, MONITORINFO *info) override;
+    HRESULT dwmExtendFrameIntoClientArea(HWND window,
+                                         const MARGINS *margins) override;
+    HRESULT dwmIsCompositionEnabled(BOOL *enabled) override;
+    LSTATUS regOpenKeyEx(HKEY key,
+                         LPCWSTR subKey,
+                         DWORD options,
+                         REGSAM access,
+                         HKEY *result) override;
+    LSTATUS regQueryValueEx(HKEY key,
+                            LPCWSTR valueName,
+                            DWORD *type,
+                            BYTE *data,
+                            DWORD *dataSize) override;
+    LSTATUS regCloseKey(HKEY key) override;
+
+    // The window's frame in screen coordinates, moved by setWindowPos().
+    // Maximized, it reaches past the work area by the frame thickness.
+    void setWindowRect(const RECT &rect);
+    // SW_SHOWNORMAL or SW_MAXIMIZE.
+    void setShowCmd(UINT showCmd);
+    void setWorkArea(const RECT &rect);
+    // SM_CYCAPTION, as after a change of the system settings or the DPI.
+    void setCaptionHeight(int height);
+    void setCompositionEnabled(bool enabled);
+    void setColorizationColor(DWORD color);
+
+    quint64 calls(Win32Call call) const;
+    quint64 totalCalls() const;
+    void resetCalls();
+
+private:
+    void record(Win32Call call);
+
+    std::array<quint64, static_cast<std::size_t>(Win32Call::Count)> m_calls{};
+    RECT m_windowRect{0, 0, 800, 600};
+    UINT m_showCmd = SW_SHOWNORMAL;
+    RECT m_workArea{0, 0, 1920, 1040};
+    // What Windows 10 reports at 96 DPI.
+    int m_captionHeight = 23;
+    bool m_compositionEnabled = true;
+    DWORD m_colorizationColor = 0xc40078d7;
+};
+
+} // namespace CSD::Internal
@@ -0,0 +1,155 @@
+#pragma once
+
+// The parts of the Win32 API the decorations use, declared for building the
+// Win32 filter on other platforms against a fake Win32Api. Layouts and values
+// follow the Windows SDK, so traces recorded on Windows replay unchanged.
+
+#include <cstdint>
+
+using BOOL = int;
+using BOOLEAN = unsigned char;
+using BYTE = unsigned char;
+using WORD = std::uint16_t;
+using DWORD = std::uint32_t;
+using UINT = unsigned int;
+using LONG = std::int32_t;
+using LSTATUS = LONG;
+using HRESULT = std::int32_t;
+using REGSAM = DWORD;
+using WPARAM = std::uintptr_t;
+using LPARAM = std::intptr_t;
+using LRESULT = std::intptr_t;
+using LPBYTE = BYTE *;
+using LPDWORD = DWORD *;
+using LPCWSTR = const wchar_t *;
+
+struct HWND__;
+using HWND = HWND__ *;
+struct HMONITOR__;
+using HMONITOR = HMONITOR__ *;
+struct HKEY__;
+using HKEY = HKEY__ *;
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+struct POINT {
+    LONG x;
+    LONG y;
+};
+
+struct RECT {
+    LONG left;
+    LONG top;
+    LONG right;
+    LONG bottom;
+};
+
+struct MSG {
+    HWND hwnd;
+    UINT message;
+    WPARAM wParam;
+    LPARAM lParam;
+    DWORD time;
+    POINT pt;
+};
+
+struct MARGINS {
+    int cxLeftWidth;
+    int cxRightWidth;
+    int cyTopHeight;
+    int cyBottomHeight;
+};
+
+struct MONITORINFO {
+    DWORD cbSize;
+    RECT rcMonitor;
+    RECT rcWork;
+    DWORD dwFlags;
+};
+
+struct WINDOWPLACEMENT {
+    UINT length;
+    UINT flags;
+    UINT showCmd;
+    POINT ptMinPosition;
+    POINT ptMaxPosition;
+    RECT rcNormalPosition;
+};
+
+struct WINDOWPOS {
+    HWND hwnd;
+    HWND hwndInsertAfter;
+    int x;
+    int y;
+    int cx;
+    int cy;
+    UINT flags;
+};
+
+struct NCCALCSIZE_PARAMS {
+    RECT rgrc[3];
+    WINDOWPOS *lppos;
+};
+
+constexpr UINT WM_CREATE = 0x0001;
+constexpr UINT WM_SIZE = 0x0005;
+constexpr UINT WM_ACTIVATE = 0x0006;
+constexpr UINT WM_SETTINGCHANGE = 0x001A;
+constexpr UINT WM_GETMINMAXINFO = 0x0024;
+constexpr UINT WM_WINDOWPOSCHANGED = 0x0047;
+constexpr UINT WM_NCCALCSIZE = 0x0083;
+constexpr UINT WM_NCHITTEST = 0x0084;
+constexpr UINT WM_NCACTIVATE = 0x0086;
+constexpr UINT WM_NCMOUSEMOVE = 0x00A0;
+constexpr UINT WM_NCLBUTTONDOWN = 0x00A1;
+constexpr UINT WM_MOUSEMOVE = 0x0200;
+constexpr UINT WM_SIZING = 0x0214;
+constexpr UINT WM_MOVING = 0x0216;
+constexpr UINT WM_ENTERSIZEMOVE = 0x0231;
+constexpr UINT WM_EXITSIZEMOVE = 0x0232;
+constexpr UINT WM_DPICHANGED = 0x02E0;
+constexpr UINT WM_THEMECHANGED = 0x031A;
+
+constexpr LRESULT HTCLIENT = 1;
+constexpr LRESULT HTCAPTION = 2;
+constexpr LRESULT HTLEFT = 10;
+constexpr LRESULT HTRIGHT = 11;
+constexpr LRESULT HTTOP = 12;
+constexpr LRESULT HTTOPLEFT = 13;
+constexpr LRESULT HTTOPRIGHT = 14;
+constexpr LRESULT HTBOTTOM = 15;
+constexpr LRESULT HTBOTTOMLEFT = 16;
+constexpr LRESULT HTBOTTOMRIGHT = 17;
+
+constexpr WPARAM WA_INACTIVE = 0;
+constexpr WPARAM WA_ACTIVE = 1;
+
+constexpr UINT SW_SHOWNORMAL = 1;
+constexpr UINT SW_MAXIMIZE = 3;
+constexpr UINT SWP_FRAMECHANGED = 0x0020;
+constexpr DWORD MONITOR_DEFAULTTONULL = 0x00000000;
+
+constexpr DWORD WS_POPUP = 0x80000000;
+constexpr DWORD WS_CLIPSIBLINGS = 0x04000000;
+constexpr DWORD WS_CLIPCHILDREN = 0x02000000;
+constexpr DWORD WS_DLGFRAME = 0x00400000;
+constexpr DWORD WS_THICKFRAME = 0x00040000;
+
+constexpr int SM_CYCAPTION = 4;
+constexpr int SM_CXSMICON = 49;
+
+constexpr HRESULT S_OK = 0;
+constexpr LSTATUS ERROR_SUCCESS = 0;
+constexpr LSTATUS ERROR_MORE_DATA = 234;
+constexpr REGSAM KEY_READ = 0x20019;
+inline const auto HKEY_CURRENT_USER =
+    reinterpret_cast<HKEY>(static_cast<std::uintptr_t>(0x80000001));
+
+#define GET_X_LPARAM(lp) (static_cast<int>(static_cast<short>((lp)&0xffff)))
+#define GET_Y_LPARAM(lp)                                                      \
+    (static_cast<int>(static_cast<short>(((lp) >> 16) & 0xffff)))
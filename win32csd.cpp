@@ -1,14 +1,46 @@
 #include "win32csd.h"
 
+#include "win32trace.h"
+
+#include <QColor>
 #include <QEvent>
+#include <QFile>
 #include <QGuiApplication>
 #include <QWidget>
 #include <QWindow>
+#include <QtMath>
 
 #include <qpa/qplatformnativeinterface.h>
 
 namespace CSD::Internal {
 
+static long hitTestForEdges(Qt::Edges edges) {
+    switch (static_cast<int>(edges)) {
+    case Qt::LeftEdge:
+        return HTLEFT;
+    case Qt::RightEdge:
+        return HTRIGHT;
+    case Qt::TopEdge:
+        return HTTOP;
+    case Qt::BottomEdge:
+        return HTBOTTOM;
+    case Qt::TopEdge | Qt::LeftEdge:
+        return HTTOPLEFT;
+    case Qt::TopEdge | Qt::RightEdge:
+        return HTTOPRIGHT;
+    case Qt::BottomEdge | Qt::LeftEdge:
+        return HTBOTTOMLEFT;
+    case Qt::BottomEdge | Qt::RightEdge:
+        return HTBOTTOMRIGHT;
+    default:
+        return 0;
+    }
+}
+
+Win32ClientSideDecorationFilter::HWNDData::HWNDData(
+    QWidget *widget, TitleBarClient *titleBar)
+    : widget(widget), titleBar(titleBar) {}
+
 Win32ClientSideDecorationFilter::HWNDData::HWNDData(
     QWidget *widget,
     std::function<bool()> isCaptionHovered,
@@ -20,55 +52,133 @@ Win32ClientSideDecorationFilter::HWNDData::HWNDData(
 
 Win32ClientSideDecorationFilter::Win32ClientSideDecorationFilter(
     QObject *parent)
-    : QObject(parent) {}
+    : QObject(parent) {
+    const auto tracePath = qEnvironmentVariable("CSD_WIN32_TRACE");
+    if (!tracePath.isEmpty()) {
+        auto trace = std::make_unique<QFile>(tracePath);
+        if (trace->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            this->m_trace = std::move(trace);
+            this->m_traceClock.start();
+        }
+    }
+}
 
 Win32ClientSideDecorationFilter::~Win32ClientSideDecorationFilter() = default;
 
+// Events the widget filter acts on, the ones after which the window's frame
+// margins may need setting again among them. The rest are turned away before
+// looking up the widget.
+static bool isWidgetEventFiltered(QEvent::Type type) {
+    switch (type) {
+    case QEvent::ActivationChange:
+    case QEvent::WindowStateChange:
+    case QEvent::Show:
+    case QEvent::WinIdChange:
+    case QEvent::ScreenChangeInternal:
+    case QEvent::Resize:
+        return true;
+    default:
+        return false;
+    }
+}
+
 bool Win32ClientSideDecorationFilter::eventFilter(QObject *watched,
                                                   QEvent *event) {
+    if (!isWidgetEventFiltered(event->type())) {
+        return false;
+    }
+    const auto hwnd = this->m_hwndsByWidget.find(watched);
+    if (hwnd == this->m_hwndsByWidget.end()) {
+        return false;
+    }
     QWidget *widget = static_cast<QWidget *>(watched);
-    auto resultIterator =
-        std::find_if(std::begin(this->appliedHWNDs),
-                     std::end(this->appliedHWNDs),
-                     [watched](const auto &hwndDataPair) {
-                         return hwndDataPair.second.widget == watched;
-                     });
+    if (event->type() == QEvent::WinIdChange) {
+        this->rekeyWidget(hwnd->second,
+                          reinterpret_cast<HWND>(widget->internalWinId()));
+    }
+    auto resultIterator = this->appliedHWNDs.find(hwnd->second);
+    if (resultIterator == std::end(this->appliedHWNDs)) {
+        return false;
+    }
+    auto &data = resultIterator->second;
+
+    if (event->type() == QEvent::Resize ||
+        event->type() == QEvent::WindowStateChange ||
+        event->type() == QEvent::Show) {
+        const bool resizable = !(widget->windowState() &
+                                 (Qt::WindowMaximized | Qt::WindowFullScreen));
+        data.hitTestMap.setFrame(
+            widget->size(),
+            0,
+            resizable && widget->minimumWidth() != widget->maximumWidth(),
+            resizable && widget->minimumHeight() != widget->maximumHeight());
+    }
 
     if (event->type() == QEvent::ActivationChange) {
-        resultIterator->second.onActivationChanged();
+        if (data.titleBar != nullptr) {
+            data.titleBar->setActive(widget->isActiveWindow());
+        } else {
+            data.onActivationChanged();
+        }
         return false;
     } else if (event->type() == QEvent::WindowStateChange) {
-        resultIterator->second.onWindowStateChanged();
+        if (data.titleBar != nullptr) {
+            data.titleBar->onWindowStateChange(widget->windowState());
+        } else {
+            data.onWindowStateChanged();
+        }
         return false;
     }
 
-    QWindow *window = widget->windowHandle();
+    this->pushCustomMargins(data);
+    return false;
+}
+
+void Win32ClientSideDecorationFilter::pushCustomMargins(HWNDData &data) {
+    QWindow *window = data.widget->windowHandle();
     if (window == nullptr) {
-        return false;
+        return;
     }
 
-    auto rect = ::RECT{0, 0, 0, 0};
-    DWORD style = WS_POPUP | WS_CLIPSIBLINGS | WS_CLIPCHILDREN |
-                  WS_THICKFRAME | WS_DLGFRAME;
-    ::AdjustWindowRectEx(&rect, style, FALSE, 0);
-
-    const auto systemCaptionMargin = ::GetSystemMetrics(SM_CYCAPTION);
-    const auto marginBottom = std::abs(rect.bottom) + systemCaptionMargin;
-    const auto margins = QMargins(-8, -marginBottom, -8, -8);
-    const auto variantMargins = qVariantFromValue(margins);
-    window->setProperty("_q_windowsCustomMargins", variantMargins);
-
+    // Most of the events and messages this is called for change nothing
+    // about the margins, setting them is left to the ones that do.
+    const auto &margins = this->customMargins();
     QPlatformWindow *platformWindow = window->handle();
+    const bool changed = margins != data.pushedMargins;
+    if (!changed && window == data.marginsWindow &&
+        platformWindow == data.marginsPlatformWindow) {
+        return;
+    }
+    const auto variantMargins = qVariantFromValue(margins);
+    if (changed || window != data.marginsWindow) {
+        window->setProperty("_q_windowsCustomMargins", variantMargins);
+        data.marginsWindow = window;
+    }
+    data.pushedMargins = margins;
     if (platformWindow == nullptr) {
-        return false;
+        return;
     }
 
     QGuiApplication::platformNativeInterface()->setWindowProperty(
         platformWindow,
         QStringLiteral("WindowsCustomMargins"),
         variantMargins);
+    data.marginsPlatformWindow = platformWindow;
+}
 
-    return false;
+const QMargins &Win32ClientSideDecorationFilter::customMargins() {
+    if (!this->m_customMargins) {
+        auto rect = ::RECT{0, 0, 0, 0};
+        DWORD style = WS_POPUP | WS_CLIPSIBLINGS | WS_CLIPCHILDREN |
+                      WS_THICKFRAME | WS_DLGFRAME;
+        win32Api().adjustWindowRectEx(&rect, style, FALSE, 0);
+
+        const auto systemCaptionMargin =
+            win32Api().getSystemMetrics(SM_CYCAPTION);
+        const auto marginBottom = std::abs(rect.bottom) + systemCaptionMargin;
+        this->m_customMargins = QMargins(-8, -marginBottom, -8, -8);
+    }
+    return *this->m_customMargins;
 }
 
 bool Win32ClientSideDecorationFilter::nativeEventFilter(
@@ -84,17 +194,34 @@ bool Win32ClientSideDecorationFilter::nativeEventFilter(
     if (resultIterator == std::end(this->appliedHWNDs)) {
         return false;
     }
+    if (this->m_trace) {
+        this->traceMessage(msg);
+    }
+
+    switch (msg->message) {
+    case WM_SETTINGCHANGE:
+    case WM_THEMECHANGED:
+    case WM_DPICHANGED:
+        // The metrics the margins come from may have changed. The window
+        // takes the new margins right away rather than with its next
+        // resize; settings and theme changes are sent to every window.
+        this->m_customMargins.reset();
+        this->pushCustomMargins(resultIterator->second);
+        break;
+    default:
+        break;
+    }
 
     if (msg->message == WM_CREATE) {
         auto clientRect = ::RECT();
-        ::GetWindowRect(msg->hwnd, &clientRect);
-        ::SetWindowPos(msg->hwnd,
-                       nullptr,
-                       clientRect.left,
-                       clientRect.top,
-                       clientRect.right - clientRect.left,
-                       clientRect.bottom - clientRect.top,
-                       SWP_FRAMECHANGED);
+        win32Api().getWindowRect(msg->hwnd, &clientRect);
+        win32Api().setWindowPos(msg->hwnd,
+                                nullptr,
+                                clientRect.left,
+                                clientRect.top,
+                                clientRect.right - clientRect.left,
+                                clientRect.bottom - clientRect.top,
+                                SWP_FRAMECHANGED);
     }
 
     if (msg->message == WM_ACTIVATE) {
@@ -103,28 +230,29 @@ bool Win32ClientSideDecorationFilter::nativeEventFilter(
         margins.cxRightWidth = 1;
         margins.cyBottomHeight = 1;
         margins.cyTopHeight = 1;
-        ::DwmExtendFrameIntoClientArea(msg->hwnd, &margins);
+        win32Api().dwmExtendFrameIntoClientArea(msg->hwnd, &margins);
         auto clientRect = ::RECT();
-        ::GetWindowRect(msg->hwnd, &clientRect);
-        ::SetWindowPos(msg->hwnd,
-                       nullptr,
-                       clientRect.left,
-                       clientRect.top,
-                       clientRect.right - clientRect.left,
-                       clientRect.bottom - clientRect.top,
-                       SWP_FRAMECHANGED);
+        win32Api().getWindowRect(msg->hwnd, &clientRect);
+        win32Api().setWindowPos(msg->hwnd,
+                                nullptr,
+                                clientRect.left,
+                                clientRect.top,
+                                clientRect.right - clientRect.left,
+                                clientRect.bottom - clientRect.top,
+                                SWP_FRAMECHANGED);
     }
 
     if (msg->message == WM_NCCALCSIZE && msg->wParam == TRUE) {
         auto windowPlacement = ::WINDOWPLACEMENT();
-        if (::GetWindowPlacement(msg->hwnd, &windowPlacement)) {
+        if (win32Api().getWindowPlacement(msg->hwnd, &windowPlacement)) {
             if (windowPlacement.showCmd == SW_MAXIMIZE) {
                 auto monitor =
-                    ::MonitorFromWindow(msg->hwnd, MONITOR_DEFAULTTONULL);
+                    win32Api().monitorFromWindow(msg->hwnd,
+                                                 MONITOR_DEFAULTTONULL);
                 if (monitor) {
                     auto monitorInfo = ::MONITORINFO();
                     monitorInfo.cbSize = sizeof(monitorInfo);
-                    if (::GetMonitorInfoW(monitor, &monitorInfo)) {
+                    if (win32Api().getMonitorInfo(monitor, &monitorInfo)) {
                         auto calcSizeParams =
                             reinterpret_cast<NCCALCSIZE_PARAMS *>(msg->lParam);
                         calcSizeParams->rgrc[0] = monitorInfo.rcWork;
@@ -138,70 +266,37 @@ bool Win32ClientSideDecorationFilter::nativeEventFilter(
     }
 
     if (msg->message == WM_NCHITTEST) {
-        *result = 0;
-        const LONG borderWidth = 8;
-        auto clientRect = ::RECT();
-        ::GetWindowRect(msg->hwnd, &clientRect);
-
-        auto x = GET_X_LPARAM(msg->lParam);
-        auto y = GET_Y_LPARAM(msg->lParam);
-
-        auto resizeWidth = resultIterator->second.widget->minimumWidth() !=
-                           resultIterator->second.widget->maximumWidth();
-        auto resizeHeight = resultIterator->second.widget->minimumHeight() !=
-                            resultIterator->second.widget->maximumHeight();
-
-        if (resizeWidth) {
-            if (x >= clientRect.left && x < clientRect.left + borderWidth) {
-                *result = HTLEFT;
-            }
-            if (x < clientRect.right && x >= clientRect.right - borderWidth) {
-                *result = HTRIGHT;
-            }
-        }
-        if (resizeHeight) {
-            if (y < clientRect.bottom &&
-                y >= clientRect.bottom - borderWidth) {
-                *result = HTBOTTOM;
-            }
-            if (y >= clientRect.top && y < clientRect.top + borderWidth) {
-                *result = HTTOP;
-            }
-        }
-        if (resizeWidth && resizeHeight) {
-            if (x >= clientRect.left && x < clientRect.left + borderWidth &&
-                y < clientRect.bottom &&
-                y >= clientRect.bottom - borderWidth) {
-                *result = HTBOTTOMLEFT;
-            }
-            if (x < clientRect.right && x >= clientRect.right - borderWidth &&
-                y < clientRect.bottom &&
-                y >= clientRect.bottom - borderWidth) {
-                *result = HTBOTTOMRIGHT;
-            }
-            if (x >= clientRect.left && x < clientRect.left + borderWidth &&
-                y >= clientRect.top && y < clientRect.top + borderWidth) {
-                *result = HTTOPLEFT;
-            }
-            if (x < clientRect.right && x >= clientRect.right - borderWidth &&
-                y >= clientRect.top && y < clientRect.top + borderWidth) {
-                *result = HTTOPRIGHT;
-            }
-        }
-
-        if (*result != 0) {
+        // The map starts at the client area, which lies inside the window
+        // rect while maximized: the frame then hangs off the monitor.
+        auto point = ::POINT{GET_X_LPARAM(msg->lParam),
+                             GET_Y_LPARAM(msg->lParam)};
+        win32Api().screenToClient(msg->hwnd, &point);
+
+        // The map is in the widget's logical coordinates.
+        const auto &data = resultIterator->second;
+        const auto dpr = data.widget->devicePixelRatioF();
+        const auto pos = QPoint(qFloor(point.x / dpr), qFloor(point.y / dpr));
+        const auto hit = data.hitTestMap.hitTest(pos);
+        switch (hit.area) {
+        case WindowArea::ResizeBorder:
+            *result = hitTestForEdges(hit.edges);
             return true;
-        }
-
-        if (resultIterator->second.isCaptionHovered()) {
+        case WindowArea::Caption:
             *result = HTCAPTION;
             return true;
+        case WindowArea::Client:
+            if (data.titleBar == nullptr && data.isCaptionHovered()) {
+                *result = HTCAPTION;
+                return true;
+            }
+            break;
         }
     }
 
     if (msg->message == WM_NCACTIVATE) {
         auto enabled = FALSE;
-        auto success = ::DwmIsCompositionEnabled(&enabled) == S_OK;
+        auto success =
+            win32Api().dwmIsCompositionEnabled(&enabled) == S_OK;
         if (!(enabled && success)) {
             *result = 1;
             return true;
@@ -222,12 +317,108 @@ void Win32ClientSideDecorationFilter::apply(
     std::function<bool()> isCaptionHovered,
     std::function<void()> onActivationChanged,
     std::function<void()> onWindowStateChanged) {
-    this->appliedHWNDs.emplace(reinterpret_cast<HWND>(widget->winId()),
-                               HWNDData(widget,
-                                        std::move(isCaptionHovered),
-                                        std::move(onActivationChanged),
-                                        std::move(onWindowStateChanged)));
-    widget->installEventFilter(this);
+    this->registerWidget(widget,
+                         HWNDData(widget,
+                                  std::move(isCaptionHovered),
+                                  std::move(onActivationChanged),
+                                  std::move(onWindowStateChanged)));
+}
+
+void Win32ClientSideDecorationFilter::apply(QWidget *widget,
+                                            TitleBarClient *titleBar) {
+    auto &data = this->registerWidget(widget, HWNDData(widget, titleBar));
+    if (data.titleBar == titleBar) {
+        titleBar->setHitTestMap(&data.hitTestMap);
+    }
+}
+
+void Win32ClientSideDecorationFilter::setFiltersApplication(bool on) {
+    this->m_filtersApplication = on;
+}
+
+Win32ClientSideDecorationFilter::HWNDData &
+Win32ClientSideDecorationFilter::registerWidget(QWidget *widget,
+                                                HWNDData data) {
+    const auto hwnd = reinterpret_cast<HWND>(widget->winId());
+    const auto [registered, inserted] =
+        this->appliedHWNDs.emplace(hwnd, std::move(data));
+    if (inserted) {
+        this->m_hwndsByWidget.emplace(widget, hwnd);
+        if (!this->m_filtersApplication) {
+            widget->installEventFilter(this);
+        }
+        connect(widget,
+                &QObject::destroyed,
+                this,
+                &Win32ClientSideDecorationFilter::unregisterWidget);
+    }
+    return registered->second;
+}
+
+void Win32ClientSideDecorationFilter::unregisterWidget(QObject *object) {
+    // Only the address is left of the widget by now.
+    const auto hwnd = this->m_hwndsByWidget.find(object);
+    if (hwnd == this->m_hwndsByWidget.end()) {
+        return;
+    }
+    this->appliedHWNDs.erase(hwnd->second);
+    this->m_hwndsByWidget.erase(hwnd);
+}
+
+void Win32ClientSideDecorationFilter::rekeyWidget(HWND &hwnd, HWND newHWND) {
+    if (newHWND == nullptr || newHWND == hwnd ||
+        this->appliedHWNDs.count(newHWND) != 0) {
+        return;
+    }
+    // The node, and with it the hit test map the title bar points to, stays
+    // where it is.
+    auto node = this->appliedHWNDs.extract(hwnd);
+    node.key() = newHWND;
+    // The new window has been told nothing yet.
+    node.mapped().marginsWindow = nullptr;
+    node.mapped().marginsPlatformWindow = nullptr;
+    this->appliedHWNDs.insert(std::move(node));
+    hwnd = newHWND;
+}
+
+void Win32ClientSideDecorationFilter::traceMessage(const MSG *msg) {
+    auto entry = Win32TraceEntry();
+    entry.time = this->m_traceClock.nsecsElapsed() / 1000;
+    entry.message = msg->message;
+    entry.wParam = msg->wParam;
+    entry.lParam = msg->lParam;
+    win32Api().getWindowRect(msg->hwnd, &entry.windowRect);
+    auto placement = ::WINDOWPLACEMENT();
+    placement.length = sizeof(placement);
+    if (win32Api().getWindowPlacement(msg->hwnd, &placement)) {
+        entry.showCmd = placement.showCmd;
+    }
+    this->m_trace->write(formatWin32TraceEntry(entry));
+}
+
+std::optional<QColor> readDWMColorizationColor() {
+    auto &api = win32Api();
+    auto handleKey = ::HKEY();
+    auto regOpenResult = api.regOpenKeyEx(HKEY_CURRENT_USER,
+                                          L"SOFTWARE\\Microsoft\\Windows\\DWM",
+                                          0,
+                                          KEY_READ,
+                                          &handleKey);
+    if (regOpenResult != ERROR_SUCCESS) {
+        return std::nullopt;
+    }
+    auto value = ::DWORD();
+    auto dwordBufferSize = ::DWORD(sizeof(::DWORD));
+    auto regQueryResult = api.regQueryValueEx(handleKey,
+                                              L"ColorizationColor",
+                                              nullptr,
+                                              reinterpret_cast<LPBYTE>(&value),
+                                              &dwordBufferSize);
+    api.regCloseKey(handleKey);
+    if (regQueryResult != ERROR_SUCCESS) {
+        return std::nullopt;
+    }
+    return QColor(static_cast<QRgb>(value));
 }
 
 } // namespace CSD::Internal
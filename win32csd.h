@@ -1,23 +1,33 @@
 #pragma once
 
-#include <Windows.h>
-#include <dwmapi.h>
-#include <windowsx.h>
+#include "csdhittest.h"
+#include "csdtitlebarclient.h"
+#include "win32api.h"
 
 #include <QAbstractNativeEventFilter>
+#include <QElapsedTimer>
 #include <QMargins>
 #include <QMetaType>
 #include <QObject>
 
 #include <functional>
+#include <memory>
+#include <optional>
 #include <unordered_map>
 
 Q_DECLARE_METATYPE(QMargins)
 
+class QColor;
+class QFile;
+class QPlatformWindow;
 class QWidget;
+class QWindow;
 
 namespace CSD::Internal {
 
+// The accent color DWM uses for window frames, if it can be read.
+std::optional<QColor> readDWMColorizationColor();
+
 class Win32ClientSideDecorationFilter : public QObject,
                                         public QAbstractNativeEventFilter {
     Q_OBJECT
@@ -28,12 +38,42 @@ private:
         std::function<bool()> isCaptionHovered;
         std::function<void()> onActivationChanged;
         std::function<void()> onWindowStateChanged;
+        // Told directly instead of the callbacks when set.
+        TitleBarClient *titleBar = nullptr;
+        // The caption comes from titleBar; without one, isCaptionHovered()
+        // is asked for what the map leaves to the client.
+        HitTestMap hitTestMap;
+        // The custom margins last set and the windows they were set on.
+        QMargins pushedMargins;
+        QWindow *marginsWindow = nullptr;
+        QPlatformWindow *marginsPlatformWindow = nullptr;
+        HWNDData(QWidget *widget, TitleBarClient *titleBar);
         HWNDData(QWidget *widget,
                  std::function<bool()> isCaptionHovered,
                  std::function<void()> onActivationChanged,
                  std::function<void()> onWindowStateChanged);
     };
     std::unordered_map<HWND, HWNDData> appliedHWNDs;
+    // The key in appliedHWNDs of each widget.
+    std::unordered_map<const QObject *, HWND> m_hwndsByWidget;
+    // Computed from the system metrics when first needed and again after
+    // they or the DPI change.
+    std::optional<QMargins> m_customMargins;
+    bool m_filtersApplication = false;
+    // Open when CSD_WIN32_TRACE names a file to record messages to.
+    std::unique_ptr<QFile> m_trace;
+    QElapsedTimer m_traceClock;
+
+    HWNDData &registerWidget(QWidget *widget, HWNDData data);
+    void unregisterWidget(QObject *object);
+    // Moves the widget registered under hwnd to newHWND after its window
+    // was created again.
+    void rekeyWidget(HWND &hwnd, HWND newHWND);
+    const QMargins &customMargins();
+    // Sets the custom margins on the window of data if they or the window
+    // changed since they were last set.
+    void pushCustomMargins(HWNDData &data);
+    void traceMessage(const MSG *msg);
 
 public:
     explicit Win32ClientSideDecorationFilter(QObject *parent = nullptr);
@@ -47,5 +87,12 @@ public:
                std::function<bool()> isCaptionHovered,
                std::function<void()> onActivationChanged,
                std::function<void()> onWindowStateChanged);
+    // Decorates widget for titleBar, which is updated directly instead of
+    // through callbacks.
+    void apply(QWidget *widget, TitleBarClient *titleBar);
+    // For an event filter installed on the application that passes on the
+    // events of all objects. apply() then leaves the widgets' own event
+    // filters alone.
+    void setFiltersApplication(bool on);
 };
 } // namespace CSD::Internal
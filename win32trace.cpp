@@ -0,0 +1,66 @@
+#include "win32trace.h"
+
+#include <QList>
+
+namespace CSD::Internal {
+
+static constexpr int kWin32TraceFields = 9;
+
+QByteArray formatWin32TraceEntry(const Win32TraceEntry &entry) {
+    auto line = QByteArray::number(entry.time);
+    line += ' ';
+    line += QByteArray::number(entry.message);
+    line += ' ';
+    line += QByteArray::number(static_cast<qulonglong>(entry.wParam));
+    line += ' ';
+    line += QByteArray::number(static_cast<qlonglong>(entry.lParam));
+    for (const auto coordinate : {entry.windowRect.left,
+                                  entry.windowRect.top,
+                                  entry.windowRect.right,
+                                  entry.windowRect.bottom}) {
+        line += ' ';
+        line += QByteArray::number(coordinate);
+    }
+    line += ' ';
+    line += QByteArray::number(entry.showCmd);
+    line += '\n';
+    return line;
+}
+
+std::optional<Win32TraceEntry> parseWin32TraceEntry(const QByteArray &line) {
+    const auto trimmed = line.trimmed();
+    if (trimmed.isEmpty() || trimmed.startsWith('#')) {
+        return std::nullopt;
+    }
+    const auto fields = trimmed.simplified().split(' ');
+    if (fields.size() != kWin32TraceFields) {
+        return std::nullopt;
+    }
+    auto ok = true;
+    auto allOk = true;
+    auto entry = Win32TraceEntry();
+    entry.time = fields[0].toLongLong(&ok);
+    allOk = allOk && ok;
+    entry.message = fields[1].toUInt(&ok);
+    allOk = allOk && ok;
+    entry.wParam = static_cast<WPARAM>(fields[2].toULongLong(&ok));
+    allOk = allOk && ok;
+    entry.lParam = static_cast<LPARAM>(fields[3].toLongLong(&ok));
+    allOk = allOk && ok;
+    entry.windowRect.left = fields[4].toInt(&ok);
+    allOk = allOk && ok;
+    entry.windowRect.top = fields[5].toInt(&ok);
+    allOk = allOk && ok;
+    entry.windowRect.right = fields[6].toInt(&ok);
+    allOk = allOk && ok;
+    entry.windowRect.bottom = fields[7].toInt(&ok);
+    allOk = allOk && ok;
+    entry.showCmd = fields[8].toUInt(&ok);
+    allOk = allOk && ok;
+    if (!allOk) {
+        return std::nullopt;
+    }
+    return entry;
+}
+
+} // namespace CSD::Internal
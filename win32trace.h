@@ -0,0 +1,32 @@
+#pragma once
+
+#include "win32api.h"
+
+#include <QByteArray>
+
+#include <optional>
+
+namespace CSD::Internal {
+
+// A message a decorated window received and the window's state as it
+// arrived. The decoration filter writes them to the file named by the
+// CSD_WIN32_TRACE environment variable, csd-win32-replay reads them back.
+struct Win32TraceEntry {
+    // Microseconds since the trace started.
+    qint64 time = 0;
+    UINT message = 0;
+    WPARAM wParam = 0;
+    // Pointers, as WM_NCCALCSIZE passes, mean nothing in another process
+    // and are replaced on replay.
+    LPARAM lParam = 0;
+    RECT windowRect{0, 0, 0, 0};
+    UINT showCmd = 0;
+};
+
+// One line of text, "time message wParam lParam left top right bottom
+// showCmd" in decimal, newline included.
+QByteArray formatWin32TraceEntry(const Win32TraceEntry &entry);
+// Empty lines and lines starting with # hold no entry.
+std::optional<Win32TraceEntry> parseWin32TraceEntry(const QByteArray &line);
+
+} // namespace CSD::Internal